@@ -0,0 +1,29 @@
+#pragma once
+
+// Marks code that must not touch the heap, for the allocation guard in
+// AllocStats.hpp. Kept apart from it (that header replaces operator new, so
+// only main's .cpp may include it) so that any code can open a guarded
+// region. Work handed to the JobSystem inside one stays guarded on the
+// worker that runs it.
+
+inline thread_local int allocGuardDepth = 0;
+
+class AllocGuard
+{
+public:
+    explicit AllocGuard(bool on = true) : on(on)
+    {
+        if (on)
+            ++allocGuardDepth;
+    }
+    ~AllocGuard()
+    {
+        if (on)
+            --allocGuardDepth;
+    }
+    AllocGuard(const AllocGuard &) = delete;
+    AllocGuard &operator=(const AllocGuard &) = delete;
+
+private:
+    bool on;
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+// Counts every heap allocation made through the global operator new.
+// Replacing the global operators is only allowed once per program, so include
+// this from the .cpp that has main() and nowhere else.
+// (The over-aligned forms, used only by Arena, are left to the library.)
+//
+// On top of the totals: AllocScope charges what one thread allocates inside
+// it to a named AllocSite, and an allocation inside an AllocGuard (the
+// simulation tick, in debug builds) is counted and reported.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <new>
+#include <vector>
+#include "AllocGuard.hpp"
+
+struct AllocStats
+{
+    std::atomic<unsigned long long> count{0};
+    std::atomic<unsigned long long> bytes{0};
+    // Allocations made inside an AllocGuard
+    std::atomic<unsigned long long> guarded{0};
+};
+
+inline AllocStats allocStats;
+
+// This thread's share of the totals, for AllocScope
+struct AllocCounts
+{
+    unsigned long long count;
+    unsigned long long bytes;
+};
+inline thread_local AllocCounts threadAllocs = {0, 0};
+
+// The first few guarded allocations are printed, the rest only counted
+const unsigned long long GUARD_REPORTS = 16;
+
+inline void onGuardedAlloc(std::size_t size)
+{
+    unsigned long long n = allocStats.guarded.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (n <= GUARD_REPORTS)
+        std::fprintf(stderr, "[alloc-guard] %zu bytes allocated inside a tick (#%llu%s)\n", size, n,
+                     n == GUARD_REPORTS ? ", not reporting more" : "");
+}
+
+void *operator new(std::size_t size)
+{
+    allocStats.count.fetch_add(1, std::memory_order_relaxed);
+    allocStats.bytes.fetch_add(size, std::memory_order_relaxed);
+    threadAllocs.count++;
+    threadAllocs.bytes += size;
+    if (allocGuardDepth > 0)
+        onGuardedAlloc(size);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    allocStats.count.fetch_add(1, std::memory_order_relaxed);
+    allocStats.bytes.fetch_add(size, std::memory_order_relaxed);
+    threadAllocs.count++;
+    threadAllocs.bytes += size;
+    if (allocGuardDepth > 0)
+        onGuardedAlloc(size);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+    return ::operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+// Allocations charged to one named piece of code, from any thread
+struct AllocSite
+{
+    explicit AllocSite(const char *name) : name(name) {}
+    const char *name;
+    std::atomic<unsigned long long> count{0};
+    std::atomic<unsigned long long> bytes{0};
+    std::atomic<unsigned long long> passes{0};
+};
+
+// Charges what this thread allocates while the scope lives to `site`.
+// Work it hands to other threads is not included.
+class AllocScope
+{
+public:
+    explicit AllocScope(AllocSite &site) : site(site), count0(threadAllocs.count), bytes0(threadAllocs.bytes) {}
+    ~AllocScope()
+    {
+        site.count.fetch_add(threadAllocs.count - count0, std::memory_order_relaxed);
+        site.bytes.fetch_add(threadAllocs.bytes - bytes0, std::memory_order_relaxed);
+        site.passes.fetch_add(1, std::memory_order_relaxed);
+    }
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+
+private:
+    AllocSite &site;
+    unsigned long long count0, bytes0;
+};
+
+// Once a second: allocations per frame, per pass of each site, and the
+// guarded ones. onFrame() from whichever thread presents, print() from one.
+class AllocReport
+{
+public:
+    AllocReport(std::initializer_list<AllocSite *> sites) : sites(sites), last(sites.size()) {}
+
+    void onFrame() { frames.fetch_add(1, std::memory_order_relaxed); }
+
+    void print()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastPrint < std::chrono::seconds(1))
+            return;
+        lastPrint = now;
+        const unsigned long long count = allocStats.count.load(std::memory_order_relaxed);
+        const unsigned long long bytes = allocStats.bytes.load(std::memory_order_relaxed);
+        const int n = std::max(1, frames.exchange(0));
+        std::printf("[alloc] per frame %.1f (%.0f B)", (double)(count - lastCount) / n, (double)(bytes - lastBytes) / n);
+        lastCount = count;
+        lastBytes = bytes;
+        for (std::size_t i = 0; i < sites.size(); ++i)
+        {
+            Snapshot cur{sites[i]->count.load(), sites[i]->bytes.load(), sites[i]->passes.load()};
+            const unsigned long long passes = std::max(1ull, cur.passes - last[i].passes);
+            std::printf(" | %s %.1f (%.0f B)", sites[i]->name, (double)(cur.count - last[i].count) / passes,
+                        (double)(cur.bytes - last[i].bytes) / passes);
+            last[i] = cur;
+        }
+        std::printf(" | in ticks %llu\n", allocStats.guarded.load(std::memory_order_relaxed));
+    }
+
+private:
+    struct Snapshot
+    {
+        unsigned long long count, bytes, passes;
+    };
+
+    std::vector<AllocSite *> sites;
+    std::vector<Snapshot> last;
+    std::atomic<int> frames{0};
+    unsigned long long lastCount = 0, lastBytes = 0;
+    std::chrono::steady_clock::time_point lastPrint = std::chrono::steady_clock::now();
+};
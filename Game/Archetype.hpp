@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Names an entity across ticks; goes stale once it is despawned
+struct SlotHandle
+{
+    int index = -1;
+    unsigned generation = 0;
+};
+
+// Every entity of one kind: they all have the components Cs..., and each
+// component is its own packed column. Rows [0, size()) are exactly the live
+// entities, so a system loops over the columns it needs and nothing else.
+//
+// Spawns and despawns are commands that wait for flush(): systems can queue
+// them while they loop, and the rows they loop over don't change under them.
+// flush() fills each hole with the last row, so rows move; the SlotHandle
+// from id() keeps naming the same entity until it is despawned.
+template <typename... Cs>
+class Archetype
+{
+public:
+    // Empty, with room for `rows` entities before the columns have to grow
+    void init(int rows)
+    {
+        clear();
+        std::apply([&](auto &...col)
+                   { (col.reserve(rows), ...); },
+                   columns);
+        ids.reserve(rows);
+        dying.reserve(rows);
+        spawns.reserve(rows);
+        rowOf.reserve(rows);
+        generations.reserve(rows);
+        freeIds.reserve(rows);
+    }
+
+    int size() const { return (int)ids.size(); }
+    // Spawns waiting for the next flush
+    int pending() const { return (int)spawns.size(); }
+    // Spawns turned away at the limit, over the archetype's whole life
+    unsigned refused() const { return refusals; }
+
+    template <typename C>
+    C *column() { return std::get<std::vector<C>>(columns).data(); }
+    template <typename C>
+    const C *column() const { return std::get<std::vector<C>>(columns).data(); }
+
+    SlotHandle id(int row) const { return ids[row]; }
+
+    // Row of the entity `h` names, or -1 once it is gone
+    int find(SlotHandle h) const
+    {
+        if (h.index < 0 || h.index >= (int)rowOf.size() || generations[h.index] != h.generation)
+            return -1;
+        return rowOf[h.index];
+    }
+
+    // Queue a new entity. False when `limit` entities, counting the queued
+    // ones, are already there.
+    bool spawn(int limit, const Cs &...values)
+    {
+        if (size() + pending() >= limit)
+        {
+            refusals++;
+            return false;
+        }
+        spawns.emplace_back(values...);
+        return true;
+    }
+
+    // Mark `row` to go at the next flush. Only writes that row's flag, so a
+    // parallel pass may despawn the rows of its own chunk.
+    void despawn(int row) { dying[row] = 1; }
+    bool despawning(int row) const { return dying[row] != 0; }
+
+    // Apply the commands: despawns, then spawns in the order they were
+    // queued. The spawned entities are the rows from the returned one on.
+    int flush()
+    {
+        // Top down, so the row moved into a hole is always one that stays
+        for (int r = size() - 1; r >= 0; --r)
+            if (dying[r])
+                remove(r);
+        const int first = size();
+        for (const std::tuple<Cs...> &values : spawns)
+            add(values, std::index_sequence_for<Cs...>());
+        spawns.clear();
+        return first;
+    }
+
+    // Bytes one entity takes in appendRows()
+    static constexpr std::size_t ROW_BYTES = (sizeof(Cs) + ...);
+
+    // Append every entity's components as raw bytes, one row after another,
+    // so a row that didn't change lines up with itself in the next image
+    // (see Rewind.hpp). Queued commands are not included.
+    void appendRows(std::vector<unsigned char> &out) const
+    {
+        static_assert((std::is_trivially_copyable<Cs>::value && ...), "components are copied as bytes");
+        std::size_t at = out.size();
+        out.resize(at + size() * ROW_BYTES);
+        for (int r = 0; r < size(); ++r)
+            std::apply([&](const auto &...col)
+                       { ((std::memcpy(&out[at], &col[r], sizeof(col[r])), at += sizeof(col[r])), ...); },
+                       columns);
+    }
+
+    // Replace every entity with `rows` read from appendRows() bytes at `in`.
+    // They get new ids. Returns the end of what was read.
+    const unsigned char *readRows(const unsigned char *in, int rows)
+    {
+        clear();
+        std::apply([&](auto &...col)
+                   { (col.resize(rows), ...); },
+                   columns);
+        for (int r = 0; r < rows; ++r)
+        {
+            std::apply([&](auto &...col)
+                       { ((std::memcpy(&col[r], in, sizeof(col[r])), in += sizeof(col[r])), ...); },
+                       columns);
+            ids.push_back(newId(r));
+            dying.push_back(0);
+        }
+        return in;
+    }
+
+    // Every entity and queued command gone at once; handles go stale
+    void clear()
+    {
+        std::apply([](auto &...col)
+                   { (col.clear(), ...); },
+                   columns);
+        ids.clear();
+        dying.clear();
+        spawns.clear();
+        // Every id handed out goes stale; their generations are kept
+        for (std::size_t i = 0; i < rowOf.size(); ++i)
+            generations[i]++;
+        rowOf.clear();
+        freeIds.clear();
+    }
+
+private:
+    // An id for a new entity at `row`: the last one freed, else a new one
+    SlotHandle newId(int row)
+    {
+        int id;
+        if (!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+            rowOf[id] = row;
+        }
+        else
+        {
+            id = (int)rowOf.size();
+            rowOf.push_back(row);
+            if (generations.size() < rowOf.size())
+                generations.push_back(0);
+        }
+        return {id, generations[id]};
+    }
+
+    void remove(int r)
+    {
+        const int last = size() - 1;
+        generations[ids[r].index]++;
+        freeIds.push_back(ids[r].index);
+        if (r != last)
+        {
+            std::apply([&](auto &...col)
+                       { ((col[r] = col[last]), ...); },
+                       columns);
+            ids[r] = ids[last];
+            dying[r] = 0;
+            rowOf[ids[r].index] = r;
+        }
+        std::apply([](auto &...col)
+                   { (col.pop_back(), ...); },
+                   columns);
+        ids.pop_back();
+        dying.pop_back();
+    }
+
+    template <std::size_t... I>
+    void add(const std::tuple<Cs...> &values, std::index_sequence<I...>)
+    {
+        ids.push_back(newId(size()));
+        dying.push_back(0);
+        (std::get<I>(columns).push_back(std::get<I>(values)), ...);
+    }
+
+    std::tuple<std::vector<Cs>...> columns;
+    std::vector<SlotHandle> ids;
+    std::vector<unsigned char> dying;
+    std::vector<std::tuple<Cs...>> spawns;
+    // Entity id -> row. An id's generation goes up each time it is freed;
+    // freed ids are handed out again, the last freed first.
+    std::vector<int> rowOf;
+    std::vector<unsigned> generations;
+    std::vector<int> freeIds;
+    unsigned refusals = 0;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// One block of memory handed out front to back. Nothing is freed on its own,
+// reset() drops everything at once, so only trivially destructible types go in.
+class Arena
+{
+public:
+    Arena() = default;
+    explicit Arena(std::size_t bytes) { reserve(bytes); }
+    ~Arena() { release(); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Throws away the old block (and everything carved from it)
+    void reserve(std::size_t bytes)
+    {
+        release();
+        base = static_cast<char *>(::operator new(bytes, std::align_val_t(ALIGN)));
+        capacity = bytes;
+        used = 0;
+    }
+
+    void *allocate(std::size_t size, std::size_t align)
+    {
+        std::size_t start = (used + align - 1) & ~(align - 1);
+        if (start + size > capacity)
+            return nullptr;
+        used = start + size;
+        return base + start;
+    }
+
+    // n default-constructed T's; throws if the arena is too small
+    template <typename T>
+    T *allocArray(int n)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena never runs destructors");
+        void *p = allocate(sizeof(T) * n, alignof(T));
+        if (!p)
+            throw std::bad_alloc();
+        T *arr = static_cast<T *>(p);
+        for (int i = 0; i < n; ++i)
+            new (&arr[i]) T();
+        return arr;
+    }
+
+    // Worst-case space allocArray<T>(n) takes, padding included
+    template <typename T>
+    static std::size_t bytesFor(int n)
+    {
+        return sizeof(T) * n + alignof(T);
+    }
+
+    // Whether `p` points into this arena's block
+    bool owns(const void *p) const
+    {
+        const char *c = static_cast<const char *>(p);
+        return base && c >= base && c < base + capacity;
+    }
+
+    void reset() { used = 0; }
+    std::size_t bytesUsed() const { return used; }
+    std::size_t bytesReserved() const { return capacity; }
+
+private:
+    static const std::size_t ALIGN = 64;
+
+    void release()
+    {
+        if (base)
+            ::operator delete(base, std::align_val_t(ALIGN));
+        base = nullptr;
+        capacity = used = 0;
+    }
+
+    char *base = nullptr;
+    std::size_t capacity = 0;
+    std::size_t used = 0;
+};
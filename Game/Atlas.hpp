@@ -0,0 +1,174 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Game.hpp"
+
+// Every game sprite packed at startup into as few textures as fit, with a
+// sub-rect per sprite. Drawing them through a SpriteBatch binds each page
+// once per batch instead of switching texture for every enemy, boss and
+// explosion. Fonts keep their own glyph pages; text is drawn after the
+// sprites, all in a row.
+
+enum AtlasSprite
+{
+    ATLAS_BACKGROUND,
+    ATLAS_PLAYER,
+    ATLAS_ENEMY,
+    ATLAS_BOSS,
+    ATLAS_EXPLOSION, // EXPLOSION_FRAMES frames from here on
+    ATLAS_SPRITES = ATLAS_EXPLOSION + EXPLOSION_FRAMES
+};
+
+struct AtlasRegion
+{
+    int page = 0;
+    sf::IntRect rect;
+};
+
+class TextureAtlas
+{
+public:
+    // Gap between packed images, so filtering never reads a neighbour
+    static const int PADDING = 2;
+
+    // Load the PNGs and pack them into pages of at most `maxPageSize`
+    // (clamped to what the GPU takes). False if an image is missing.
+    bool build(unsigned maxPageSize = 2048)
+    {
+        const char *files[] = {"background.png", "Player2.png", "Enemy1.png", "Boss1.png", "explosion.png"};
+        const int IMAGES = sizeof(files) / sizeof(files[0]);
+        std::vector<sf::Image> images(IMAGES);
+        for (int i = 0; i < IMAGES; ++i)
+            if (!images[i].loadFromFile(files[i]))
+                return false;
+
+        // Shelf packing, tallest first: fill a row left to right, then start
+        // the next row under the tallest image of this one
+        const int limit = (int)std::min(maxPageSize, sf::Texture::getMaximumSize());
+        std::vector<int> order(IMAGES);
+        for (int i = 0; i < IMAGES; ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+                         { return images[a].getSize().y > images[b].getSize().y; });
+
+        std::vector<AtlasRegion> placed(IMAGES);
+        std::vector<sf::Vector2i> extent; // used size of each page
+        int page = 0, x = 0, y = 0, shelf = 0;
+        extent.push_back({0, 0});
+        for (int i : order)
+        {
+            const int w = (int)images[i].getSize().x, h = (int)images[i].getSize().y;
+            if (x > 0 && x + w > limit)
+            {
+                x = 0;
+                y += shelf + PADDING;
+                shelf = 0;
+            }
+            if (y > 0 && y + h > limit)
+            {
+                page++;
+                extent.push_back({0, 0});
+                x = y = shelf = 0;
+            }
+            placed[i] = {page, sf::IntRect(x, y, w, h)};
+            extent[page].x = std::max(extent[page].x, x + w);
+            extent[page].y = std::max(extent[page].y, y + h);
+            x += w + PADDING;
+            shelf = std::max(shelf, h);
+        }
+
+        pages.clear();
+        for (const sf::Vector2i &size : extent)
+        {
+            sf::Image sheet;
+            sheet.create((unsigned)size.x, (unsigned)size.y, sf::Color::Transparent);
+            for (int i = 0; i < IMAGES; ++i)
+                if (placed[i].page == (int)pages.size())
+                    sheet.copy(images[i], (unsigned)placed[i].rect.left, (unsigned)placed[i].rect.top);
+            pages.push_back(std::make_unique<sf::Texture>());
+            if (!pages.back()->loadFromImage(sheet))
+                return false;
+        }
+
+        regions[ATLAS_BACKGROUND] = placed[0];
+        regions[ATLAS_PLAYER] = placed[1];
+        regions[ATLAS_ENEMY] = placed[2];
+        regions[ATLAS_BOSS] = placed[3];
+        // The explosion sheet is EXPLOSION_FRAMES_PER_ROW frames square
+        const AtlasRegion &sheet = placed[4];
+        const int fw = sheet.rect.width / EXPLOSION_FRAMES_PER_ROW;
+        const int fh = sheet.rect.height / EXPLOSION_FRAMES_PER_ROW;
+        for (int f = 0; f < EXPLOSION_FRAMES; ++f)
+        {
+            const int col = f % EXPLOSION_FRAMES_PER_ROW, row = f / EXPLOSION_FRAMES_PER_ROW;
+            regions[ATLAS_EXPLOSION + f] = {sheet.page, sf::IntRect(sheet.rect.left + col * fw, sheet.rect.top + row * fh, fw, fh)};
+        }
+        std::cout << "Atlas: " << IMAGES << " images on " << pages.size() << " page(s)\n";
+        return true;
+    }
+
+    int pageCount() const { return (int)pages.size(); }
+    const sf::Texture &page(int i) const { return *pages[i]; }
+    const AtlasRegion &region(int sprite) const { return regions[sprite]; }
+
+    // A stand-alone sprite of `sprite`, for the odd draw outside a batch
+    sf::Sprite sprite(int sprite) const
+    {
+        const AtlasRegion &r = regions[sprite];
+        return sf::Sprite(*pages[r.page], r.rect);
+    }
+
+private:
+    std::vector<std::unique_ptr<sf::Texture>> pages;
+    AtlasRegion regions[ATLAS_SPRITES];
+};
+
+// Atlas sprites queued as triangles, one list per page. draw() issues one
+// draw call per page in use, in page order, whatever order they were added in,
+// so add everything that shares a layer and draw it once.
+class SpriteBatch
+{
+public:
+    // `sprite` centred on `center`, scaled by `scale` and tinted by `color`
+    void add(const TextureAtlas &atlas, int sprite, const sf::Vector2f &center, float scale = 1.f,
+             const sf::Color &color = sf::Color::White)
+    {
+        const AtlasRegion &r = atlas.region(sprite);
+        if ((int)vertices.size() <= r.page)
+            vertices.resize(r.page + 1);
+        const float hw = r.rect.width * scale * 0.5f, hh = r.rect.height * scale * 0.5f;
+        const float u0 = (float)r.rect.left, v0 = (float)r.rect.top;
+        const float u1 = u0 + r.rect.width, v1 = v0 + r.rect.height;
+        const sf::Vertex tl({center.x - hw, center.y - hh}, color, {u0, v0});
+        const sf::Vertex tr({center.x + hw, center.y - hh}, color, {u1, v0});
+        const sf::Vertex br({center.x + hw, center.y + hh}, color, {u1, v1});
+        const sf::Vertex bl({center.x - hw, center.y + hh}, color, {u0, v1});
+        std::vector<sf::Vertex> &v = vertices[r.page];
+        v.push_back(tl);
+        v.push_back(tr);
+        v.push_back(br);
+        v.push_back(tl);
+        v.push_back(br);
+        v.push_back(bl);
+    }
+
+    // Draw and empty the batch, keeping its memory
+    void draw(sf::RenderTarget &target, const TextureAtlas &atlas)
+    {
+        for (std::size_t p = 0; p < vertices.size(); ++p)
+        {
+            if (vertices[p].empty())
+                continue;
+            target.draw(vertices[p].data(), vertices[p].size(), sf::Triangles, sf::RenderStates(&atlas.page((int)p)));
+            vertices[p].clear();
+        }
+    }
+
+private:
+    std::vector<std::vector<sf::Vertex>> vertices; // by page
+};
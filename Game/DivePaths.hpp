@@ -0,0 +1,136 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Dive trajectories. Each pattern is a chain of cubic Bezier segments, baked
+// once into points spaced evenly by arc length, so a diver only advances a
+// distance and reads its spot off the table: constant speed along the
+// curve, and no sqrt or normalize per diver per tick.
+
+struct Cubic
+{
+    sf::Vector2f p0, c0, c1, p1;
+
+    sf::Vector2f at(float t) const
+    {
+        float u = 1.f - t;
+        return p0 * (u * u * u) + c0 * (3.f * u * u * t) + c1 * (3.f * u * t * t) + p1 * (t * t * t);
+    }
+};
+
+// A curve as `points` evenly spaced along it, from arc length 0 to length
+class BakedPath
+{
+public:
+    BakedPath() = default;
+
+    // Samples each segment finely, then picks `points` spots at equal
+    // arc-length steps
+    BakedPath(const std::vector<Cubic> &segments, int points)
+    {
+        const int FINE = 256; // per segment
+        std::vector<sf::Vector2f> fine;
+        std::vector<float> dist;
+        fine.push_back(segments.front().p0);
+        dist.push_back(0.f);
+        for (const Cubic &c : segments)
+            for (int k = 1; k <= FINE; ++k)
+            {
+                sf::Vector2f p = c.at((float)k / FINE);
+                sf::Vector2f d = p - fine.back();
+                dist.push_back(dist.back() + std::sqrt(d.x * d.x + d.y * d.y));
+                fine.push_back(p);
+            }
+
+        total = dist.back();
+        step = total / (points - 1);
+        table.resize(points);
+        std::size_t j = 1;
+        for (int i = 0; i < points; ++i)
+        {
+            float s = std::min(i * step, total);
+            while (j + 1 < dist.size() && dist[j] < s)
+                ++j;
+            float span = dist[j] - dist[j - 1];
+            float f = span > 0.f ? (s - dist[j - 1]) / span : 0.f;
+            table[i] = fine[j - 1] + (fine[j] - fine[j - 1]) * f;
+        }
+    }
+
+    float length() const { return total; }
+
+    // The spot `s` along the curve, clamped to its ends
+    sf::Vector2f at(float s) const
+    {
+        float x = std::max(0.f, s) / step;
+        int i = (int)x;
+        if (i >= (int)table.size() - 1)
+            return table.back();
+        float f = x - i;
+        return table[i] + (table[i + 1] - table[i]) * f;
+    }
+
+    // Heading at `s`, scaled to one unit of arc length
+    sf::Vector2f heading(float s) const
+    {
+        int i = std::min((int)(std::max(0.f, s) / step), (int)table.size() - 2);
+        return (table[i + 1] - table[i]) / step;
+    }
+
+private:
+    std::vector<sf::Vector2f> table;
+    float step = 1.f;
+    float total = 0.f;
+};
+
+// Dive patterns, in pixels from where the dive starts. They swing toward +x
+// first; a mirrored dive flips x. All of them end well below the screen.
+enum DivePattern
+{
+    DIVE_PLUNGE,
+    DIVE_SWOOP,
+    DIVE_LOOP,
+    DIVE_WEAVE,
+    DIVE_PATTERNS
+};
+
+struct DivePaths
+{
+    BakedPath dives[DIVE_PATTERNS];
+    // The way back: (0, 0) to (1, 0) with a bulge to the side, stretched
+    // onto the line from where the dive ended to the diver's slot
+    BakedPath back;
+};
+
+inline DivePaths bakeDivePaths()
+{
+    const int POINTS = 512;
+    DivePaths p;
+    p.dives[DIVE_PLUNGE] = BakedPath({{{0, 0}, {0, 300}, {0, 600}, {0, 900}}}, POINTS);
+    p.dives[DIVE_SWOOP] = BakedPath({{{0, 0}, {120, -60}, {220, 150}, {160, 350}},
+                                     {{160, 350}, {100, 550}, {-40, 700}, {-40, 900}}},
+                                    POINTS);
+    // A loop of radius 70 right after leaving, then down to the left
+    const float K = 38.7f; // 70 * 0.5523, a quarter circle as a cubic
+    p.dives[DIVE_LOOP] = BakedPath({{{0, 0}, {0, -K}, {70 - K, -70}, {70, -70}},
+                                    {{70, -70}, {70 + K, -70}, {140, -K}, {140, 0}},
+                                    {{140, 0}, {140, K}, {70 + K, 70}, {70, 70}},
+                                    {{70, 70}, {20, 70}, {-40, 200}, {-40, 400}},
+                                    {{-40, 400}, {-40, 600}, {40, 750}, {40, 900}}},
+                                   POINTS);
+    p.dives[DIVE_WEAVE] = BakedPath({{{0, 0}, {150, 150}, {-150, 300}, {0, 450}},
+                                     {{0, 450}, {150, 600}, {-150, 750}, {0, 900}}},
+                                    POINTS);
+    p.back = BakedPath({{{0, 0}, {0.3f, 0.3f}, {0.7f, 0.3f}, {1, 0}}}, 128);
+    return p;
+}
+
+// Baked on first use; the game calls it at startup
+inline const DivePaths &divePaths()
+{
+    static const DivePaths paths = bakeDivePaths();
+    return paths;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+
+// SSE2 is always there on x64 and on x86 builds that ask for it; anything
+// else takes the scalar loops, which give the same floats
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENEMY_KERNELS_SSE2
+#endif
+
+// Batch updates of enemy columns. Each works on plain float arrays, so a
+// column of one-float components (or of x/y pairs) is passed as float*.
+
+// pos[i] = base[i] + offset for rows [0, n). Rows are (x, y) pairs, so one
+// register moves two enemies.
+inline void placeInFormation(float *pos, const float *base, int n, sf::Vector2f offset)
+{
+    const int floats = 2 * n;
+    int i = 0;
+#ifdef ENEMY_KERNELS_SSE2
+    const __m128 off = _mm_setr_ps(offset.x, offset.y, offset.x, offset.y);
+    for (; i + 4 <= floats; i += 4)
+        _mm_storeu_ps(pos + i, _mm_add_ps(_mm_loadu_ps(base + i), off));
+#endif
+    for (; i < floats; i += 2)
+    {
+        pos[i] = base[i] + offset.x;
+        pos[i + 1] = base[i + 1] + offset.y;
+    }
+}
+
+// t += dt for rows [0, n)
+inline void advancePhases(float *t, int n, float dt)
+{
+    int i = 0;
+#ifdef ENEMY_KERNELS_SSE2
+    const __m128 step = _mm_set1_ps(dt);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(t + i, _mm_add_ps(_mm_loadu_ps(t + i), step));
+#endif
+    for (; i < n; ++i)
+        t[i] += dt;
+}
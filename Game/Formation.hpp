@@ -0,0 +1,91 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+
+// The block of enemies that marches left and right. Members stand at
+// basePos + offset, so moving, dropping or turning the whole block is one
+// change to `offset`/`dir`. Base x is cut into narrow columns with a member
+// count each; the outermost occupied columns give the block's extent, so the
+// edge test never has to look at the members themselves.
+class Formation
+{
+public:
+    sf::Vector2f offset;
+    float dir = 1.f;
+
+    // Empty, back at the origin, heading right
+    void reset()
+    {
+        offset = {0.f, 0.f};
+        dir = 1.f;
+        members = 0;
+        minCol = COLUMNS;
+        maxCol = -1;
+        std::fill(count, count + COLUMNS, 0);
+    }
+
+    int size() const { return members; }
+
+    void join(float baseX, float radius)
+    {
+        int c = columnOf(baseX);
+        if (count[c]++ == 0)
+        {
+            left[c] = baseX - radius;
+            right[c] = baseX + radius;
+        }
+        else
+        {
+            left[c] = std::min(left[c], baseX - radius);
+            right[c] = std::max(right[c], baseX + radius);
+        }
+        minCol = std::min(minCol, c);
+        maxCol = std::max(maxCol, c);
+        members++;
+    }
+
+    // `baseX` must be the one the member joined with. The outer columns only
+    // move inward past columns that are empty by now.
+    void leave(float baseX)
+    {
+        int c = columnOf(baseX);
+        count[c]--;
+        if (--members == 0)
+        {
+            minCol = COLUMNS;
+            maxCol = -1;
+            return;
+        }
+        while (count[minCol] == 0)
+            ++minCol;
+        while (count[maxCol] == 0)
+            --maxCol;
+    }
+
+    // Screen extent of the members; only meaningful while size() > 0
+    float minX() const { return left[minCol] + offset.x; }
+    float maxX() const { return right[maxCol] + offset.x; }
+
+private:
+    // Wide enough for any base position a member can have: the screen plus
+    // the distance the block can drift either way
+    static constexpr float COLUMN_WIDTH = 8.f;
+    static constexpr float FIRST_X = -2048.f;
+    static const int COLUMNS = 768;
+
+    static int columnOf(float baseX)
+    {
+        int c = (int)std::floor((baseX - FIRST_X) / COLUMN_WIDTH);
+        return std::max(0, std::min(COLUMNS - 1, c));
+    }
+
+    int members = 0;
+    int minCol = COLUMNS;
+    int maxCol = -1;
+    int count[COLUMNS] = {};
+    // Extent of each column's members, kept while the column is occupied
+    float left[COLUMNS] = {};
+    float right[COLUMNS] = {};
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Arena.hpp"
+
+// Scratch memory for one frame: every thread that draws or formats text has
+// its own, and resets it at the top of its loop. Allocating is a pointer
+// bump, freeing does nothing and reset() takes everything back, so per-frame
+// temporaries never reach the heap or fragment it, however long a session
+// runs. Nothing made from it may outlive the frame.
+// When a frame wants more than the block holds, the rest comes from the heap
+// as usual and is freed as usual.
+class FrameArena
+{
+public:
+    static const std::size_t DEFAULT_BYTES = 64 * 1024;
+
+    explicit FrameArena(std::size_t bytes = DEFAULT_BYTES) : arena(bytes) {}
+
+    void *allocate(std::size_t size, std::size_t align)
+    {
+        if (void *p = arena.allocate(size, align))
+            return p;
+        return ::operator new(size);
+    }
+
+    void deallocate(void *p)
+    {
+        if (!arena.owns(p))
+            ::operator delete(p);
+    }
+
+    void reset() { arena.reset(); }
+    std::size_t bytesUsed() const { return arena.bytesUsed(); }
+
+private:
+    Arena arena;
+};
+
+// This thread's frame arena
+inline thread_local FrameArena frameArena;
+
+// Standard allocator over a FrameArena, by default the calling thread's
+template <typename T>
+struct FrameAllocator
+{
+    using value_type = T;
+
+    FrameAllocator() noexcept : arena(&frameArena) {}
+    explicit FrameAllocator(FrameArena &a) noexcept : arena(&a) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U> &other) noexcept : arena(other.arena) {}
+
+    T *allocate(std::size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T *p, std::size_t) noexcept { arena->deallocate(p); }
+
+    FrameArena *arena;
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T> &a, const FrameAllocator<U> &b) { return a.arena == b.arena; }
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T> &a, const FrameAllocator<U> &b) { return a.arena != b.arena; }
+
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+// printf into a FrameString
+template <typename... Args>
+FrameString frameFormat(const char *format, Args... args)
+{
+    FrameString s;
+    const int n = std::snprintf(nullptr, 0, format, args...);
+    if (n <= 0)
+        return s;
+    s.resize((std::size_t)n);
+    std::snprintf(&s[0], (std::size_t)n + 1, format, args...);
+    return s;
+}
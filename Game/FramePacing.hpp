@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <SFML/System/Sleep.hpp>
+#include <SFML/System/Time.hpp>
+
+enum PacingMode
+{
+    PACING_VSYNC,      // display() waits for the monitor (the old behaviour)
+    PACING_UNCAPPED,   // draw as fast as possible
+    PACING_LIMITED,    // fixed frame rate, sleep then spin
+    PACING_LOW_LATENCY // fixed frame rate, input polled and the game drawn right after the wait
+};
+const int PACING_MODE_COUNT = 4;
+
+inline const char *pacingName(PacingMode mode)
+{
+    switch (mode)
+    {
+    case PACING_UNCAPPED:
+        return "uncapped";
+    case PACING_LIMITED:
+        return "limit";
+    case PACING_LOW_LATENCY:
+        return "low-latency";
+    default:
+        return "vsync";
+    }
+}
+
+inline PacingMode parsePacingMode(const std::string &name)
+{
+    for (int m = 0; m < PACING_MODE_COUNT; ++m)
+        if (name == pacingName((PacingMode)m))
+            return (PacingMode)m;
+    return PACING_VSYNC;
+}
+
+// Decides when the next frame may start. Vsync and uncapped leave that to
+// the driver; the other modes sleep most of the way to the deadline and spin
+// the rest, since a plain sleep can overshoot by a millisecond or more.
+class FramePacer
+{
+public:
+    FramePacer(PacingMode mode, int fps) : pacing(mode) { setFps(fps); }
+
+    PacingMode mode() const { return pacing; }
+    void setMode(PacingMode mode) { pacing = mode; }
+    bool usesVsync() const { return pacing == PACING_VSYNC; }
+    int fps() const { return targetFps; }
+
+    void setFps(int fps)
+    {
+        targetFps = fps > 0 ? fps : 120;
+        period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+        next = Clock::now();
+    }
+
+    // Blocks until the next frame is due
+    void waitForNextFrame()
+    {
+        if (pacing != PACING_LIMITED && pacing != PACING_LOW_LATENCY)
+            return;
+
+        Clock::time_point now = Clock::now();
+        next += period;
+        // Fell more than a frame behind: start counting again from now
+        // instead of rushing out a burst of frames
+        if (now > next + period)
+            next = now;
+
+        Clock::duration coarse = next - now - SPIN_MARGIN;
+        if (coarse > Clock::duration::zero())
+            sf::sleep(sf::microseconds((sf::Int64)std::chrono::duration_cast<std::chrono::microseconds>(coarse).count()));
+        while (Clock::now() < next)
+            std::this_thread::yield();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr Clock::duration SPIN_MARGIN = std::chrono::microseconds(1500);
+
+    PacingMode pacing;
+    int targetFps = 120;
+    Clock::duration period{};
+    Clock::time_point next;
+};
+
+// How hard a screen with nothing going on still needs to run
+enum IdleLevel
+{
+    IDLE_NONE,  // full rate
+    IDLE_SLOW,  // still animating something: IDLE_FPS is enough
+    IDLE_BLOCK  // nothing moves: sleep in waitEvent until there is input
+};
+
+// Time since the last input. Screens use it to let their animation settle
+// and then stop drawing altogether, so a game left paused costs no CPU.
+class IdleTracker
+{
+public:
+    static constexpr float SETTLE_SECONDS = 3.f;
+    static const int IDLE_FPS = 20;
+
+    void onInput() { quiet = 0.f; }
+    void onFrame(float dt) { quiet += dt; }
+    bool settled() const { return quiet >= SETTLE_SECONDS; }
+
+private:
+    float quiet = 0.f;
+};
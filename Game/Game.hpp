@@ -0,0 +1,2142 @@
+#pragma once
+
+// Game rules and data shared by the game and the tools (bench.cpp).
+// Nothing in here draws or plays sound.
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Tuning.hpp"
+#include "Archetype.hpp"
+#include "Formation.hpp"
+#include "EnemyKernels.hpp"
+#include "JobSystem.hpp"
+#include "TimerWheel.hpp"
+#include "DivePaths.hpp"
+
+const int WINDOW_WIDTH = 1500;
+const int WINDOW_HEIGHT = 800;
+
+// Speeds, formation layout, cooldowns and effect timings live in `tuning`
+// (see Tuning.hpp / Tuning.txt) so they can be changed without a rebuild.
+
+// Live entities each archetype allows. Chosen at startup (see parseCapacities);
+// carveWorld() reserves the columns for them up front.
+struct Capacities
+{
+    int enemies = 36;
+    int pBullets = 64;
+    int eBullets = 64;
+    int items = 16;
+    int explosions = 32;
+    int pickupEffects = 16;
+};
+
+// Stress mode: hundreds of enemies and a screen full of bullets
+const Capacities STRESS_CAPACITIES = {600, 256, 10000, 64, 256, 16};
+
+// Largest pool sizes the flags, or a co-op host, may ask for
+const Capacities MAX_CAPACITIES = {4096, 4096, 65536, 1024, 4096, 1024};
+
+// Every pool between 1 and its MAX_CAPACITIES size
+inline bool capacitiesInRange(const Capacities &c)
+{
+    const int sizes[] = {c.enemies, c.pBullets, c.eBullets, c.items, c.explosions, c.pickupEffects};
+    const int limits[] = {MAX_CAPACITIES.enemies, MAX_CAPACITIES.pBullets, MAX_CAPACITIES.eBullets,
+                          MAX_CAPACITIES.items, MAX_CAPACITIES.explosions, MAX_CAPACITIES.pickupEffects};
+    for (int i = 0; i < 6; ++i)
+        if (sizes[i] < 1 || sizes[i] > limits[i])
+            return false;
+    return true;
+}
+const int STRESS_ROWS = 12;
+const int STRESS_COLS = 40;
+
+// Survival keeps adding enemies; its pool grows up to this many live ones
+const int SURVIVAL_MAX_ENEMIES = 1024;
+
+// updateWorld always advances by exactly one tick; the game runs as many
+// ticks as real time calls for, dropping anything past MAX_FRAME_SECONDS
+const float TICK_SECONDS = 1.f / 60.f;
+const float MAX_FRAME_SECONDS = 0.25f;
+
+// Longest wait ticksFor() hands out, about 200 days. TimerWheel compares
+// ticks as signed differences, so waits have to stay well short of 2^31.
+const unsigned MAX_WAIT_TICKS = 1u << 30;
+
+// Whole ticks nearest to `seconds`, at least one and at most MAX_WAIT_TICKS.
+// Infinity and NaN count as the longest wait.
+inline unsigned ticksFor(float seconds)
+{
+    const float ticks = seconds / TICK_SECONDS;
+    if (std::isnan(ticks) || ticks >= (float)MAX_WAIT_TICKS)
+        return MAX_WAIT_TICKS;
+    return (unsigned)std::max(1L, std::lround(ticks));
+}
+
+// Formation layout
+const int FORM_ROWS = 3;
+const int FORM_COLS = 6;
+
+// EXPLOSION EFFECT
+const int EXPLOSION_FRAMES = 16;
+const int EXPLOSION_FRAMES_PER_ROW = 4;
+
+enum GameMode
+{
+    MODE_NORMAL,
+    MODE_HARD,
+    MODE_SURVIVAL,
+    MODE_STRESS
+};
+
+inline const char *modeName(GameMode mode)
+{
+    switch (mode)
+    {
+    case MODE_HARD:
+        return "hard";
+    case MODE_SURVIVAL:
+        return "survival";
+    case MODE_STRESS:
+        return "stress";
+    default:
+        return "normal";
+    }
+}
+
+enum ShootingStyle
+{
+    SINGLE,
+    DOUBLE,
+    SPREAD
+};
+
+inline const char *styleName(ShootingStyle style)
+{
+    switch (style)
+    {
+    case DOUBLE:
+        return "Double";
+    case SPREAD:
+        return "Spread";
+    default:
+        return "Single";
+    }
+}
+
+enum ItemType
+{
+    ITEM_DMG,
+    ITEM_SINGLE,
+    ITEM_DOUBLE,
+    ITEM_SPREAD,
+    HEAL
+};
+
+// `value` in binary, 4 digits up to 15 and 6 above, added to the end of `s`
+template <typename String>
+void appendBinary(String &s, int value)
+{
+    int width = (value <= 15 ? 4 : 6);
+    for (int i = width - 1; i >= 0; i--)
+    {
+        s.push_back(((value >> i) & 1) ? '1' : '0');
+    }
+}
+
+inline std::string toBinary(int value)
+{
+    std::string s;
+    s.reserve(6);
+    appendBinary(s, value);
+    return s;
+}
+
+// toBinary stacked one digit per line, as drawn on bullets
+inline std::string makeBulletLabel(int value)
+{
+    std::string bin = toBinary(value);
+    std::string vertical;
+    vertical.reserve(bin.size() * 2);
+    for (size_t i = 0; i < bin.size(); i++)
+    {
+        vertical.push_back(bin[i]);
+        if (i != bin.size() - 1)
+            vertical.push_back('\n');
+    }
+    return vertical;
+}
+
+inline float dist2(const sf::Vector2f &a, const sf::Vector2f &b)
+{
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+inline bool circleHit(const sf::Vector2f &a, float ra, const sf::Vector2f &b, float rb)
+{
+    float r = ra + rb;
+    return dist2(a, b) <= r * r;
+}
+
+// Swept circleHit: when a circle moving from `a` by `move` first touches a
+// still circle at `b`, as a share of the move in [0, 1], or -1 if it
+// doesn't. A fast bullet can step clean over a small enemy in one long
+// tick; this still sees it. The sqrt is only taken for an actual hit.
+inline float sweptCircleHit(const sf::Vector2f &a, const sf::Vector2f &move, float ra, const sf::Vector2f &b, float rb)
+{
+    float r = ra + rb;
+    sf::Vector2f m = a - b;
+    float c = m.x * m.x + m.y * m.y - r * r;
+    if (c <= 0.f)
+        return 0.f; // touching from the start
+    float half = m.x * move.x + m.y * move.y;
+    if (half >= 0.f)
+        return -1.f; // moving away
+    float len2 = move.x * move.x + move.y * move.y;
+    float disc = half * half - len2 * c;
+    if (disc < 0.f)
+        return -1.f; // passes by
+    // First touch at (-half - sqrt(disc)) / len2; past the end of the move?
+    float reach = -half - len2;
+    if (reach > 0.f && reach * reach > disc)
+        return -1.f;
+    return (-half - std::sqrt(disc)) / len2;
+}
+
+struct Player
+{
+    sf::Vector2f pos{WINDOW_WIDTH / 2.f, WINDOW_HEIGHT - 70.0f};
+    float radius = 20.f;
+    int hp = 100;
+    int damage = 20;
+    ShootingStyle style = SINGLE;
+    bool canShoot = true; // fire key was up last tick
+};
+
+// Co-op has a second ship; see World::player2
+const int MAX_PLAYERS = 2;
+
+// ---------------------------------------------------------------------------
+// Components. Every entity is a row of an Archetype (see Archetype.hpp) made
+// of some of these; systems take the columns they need.
+
+struct Position : sf::Vector2f
+{
+    Position() = default;
+    Position(const sf::Vector2f &v) : sf::Vector2f(v) {}
+};
+
+struct Velocity : sf::Vector2f
+{
+    Velocity() = default;
+    Velocity(const sf::Vector2f &v) : sf::Vector2f(v) {}
+};
+
+// Enemy state is split so the per-tick kernels (EnemyKernels.hpp) stream
+// through nothing but what they change: positions, base positions and the
+// bobbing phase. Cooldowns are ticks on World::timers, not countdowns.
+
+// Where an enemy stands in the formation, before the formation's offset
+struct BasePos : sf::Vector2f
+{
+    BasePos() = default;
+    BasePos(const sf::Vector2f &v) : sf::Vector2f(v) {}
+};
+
+struct Bob
+{
+    float t = 0.f; // drives the bobbing
+};
+
+struct Weapon
+{
+    unsigned readyTick = 0; // tick of the next shot
+};
+
+struct HitFlash
+{
+    unsigned endTick = 0; // lit until this tick; 0 when out
+};
+
+struct Body
+{
+    float radius = 26.f;
+};
+
+struct Health
+{
+    int hp = 10;
+    int maxHp = 100;
+};
+
+// A dive flies one of the baked paths of DivePaths.hpp, and the way back
+// flies divePaths().back; each leg starts where the one before it ended
+struct Dive
+{
+    bool attackMode = false;
+    bool returning = false;
+    float attackTimer = 0.f;
+    unsigned char pattern = DIVE_PLUNGE;
+    bool mirrored = false;
+    float along = -1.f;  // pixels along the dive, or share of the way back; -1 until the leg starts
+    float rate = 0.f;    // way back: share of it per second
+    sf::Vector2f from;   // where the leg started
+};
+
+struct Rank
+{
+    int gridX = -1, gridY = -1;
+    bool inFormation = false; // counted in World::formation
+};
+
+struct BossBrain
+{
+    int bossType = 0;
+    int phase = 1;
+};
+
+// The label of a bullet is drawn from a per-damage cache at render time
+struct Damage
+{
+    int value = 1;
+};
+
+struct Pickup
+{
+    ItemType type = ITEM_DMG;
+};
+
+struct ExplosionFrame
+{
+    float frameTimer = 0.f;
+    int currentFrame = 0;
+};
+
+struct Ring
+{
+    float radius = 10.f;
+    float alpha = 255.f; // Transparent
+    sf::Color color;
+};
+
+using EnemyRows = Archetype<Position, BasePos, Bob, Weapon, HitFlash, Dive, Body, Health, Rank>;
+using BossRows = Archetype<Position, BasePos, Bob, Weapon, HitFlash, Dive, Body, Health, Rank, BossBrain>;
+
+// The kernels see these columns as float arrays
+static_assert(sizeof(Position) == 2 * sizeof(float) && sizeof(BasePos) == 2 * sizeof(float), "x/y pairs");
+static_assert(sizeof(Bob) == sizeof(float), "one-float components");
+using BulletRows = Archetype<Position, Velocity, Damage>;
+using ItemRows = Archetype<Position, Pickup>;
+using ExplosionRows = Archetype<Position, ExplosionFrame>;
+using RingRows = Archetype<Position, Ring>;
+
+const float BULLET_RADIUS = 14.f;
+const float ITEM_RADIUS = 16.f;
+
+// One enemy or boss as the wave and summon code describes it; addEnemy()
+// splits it into components
+struct Enemy
+{
+    bool boss = false;
+    int bossType = 0;
+    int phase = 1;
+    bool attackMode = false;
+    bool returning = false;
+    sf::Vector2f pos;
+    sf::Vector2f basePos;
+    float radius = 26.f;
+    float t = 0.f;
+    float fireCD = 1.0f;
+    int hp = 10;
+    int maxHp = 100;
+    int gridX = -1, gridY = -1;
+    float attackTimer = 0.f;
+};
+
+inline const char *itemLabel(ItemType type)
+{
+    switch (type)
+    {
+    case ITEM_DMG:
+        return "DMG+1";
+    case ITEM_SINGLE:
+        return "Single";
+    case ITEM_DOUBLE:
+        return "Double";
+    case ITEM_SPREAD:
+        return "Spread";
+    default:
+        return "Heal";
+    }
+}
+
+// Pickup ring colour, also used for the item's label
+inline sf::Color itemColor(ItemType type)
+{
+    switch (type)
+    {
+    case ITEM_DMG:
+        return sf::Color::Green;
+    case ITEM_SINGLE:
+        return sf::Color::Cyan;
+    case ITEM_DOUBLE:
+        return sf::Color::Magenta;
+    case ITEM_SPREAD:
+        return sf::Color::Yellow;
+    default:
+        return sf::Color::Green;
+    }
+}
+
+// High Scores management
+struct HighScoreEntry
+{
+    int score;
+    int level;
+};
+
+inline void loadHighScores(std::map<GameMode, std::vector<HighScoreEntry>> &allScores)
+{
+    allScores.clear();
+    std::ifstream in("HighScores.txt");
+    if (!in.is_open())
+        return;
+
+    std::string tag;
+    while (in >> tag)
+    {
+        if (tag == "MODE")
+        {
+            int m;
+            in >> m;
+            int n;
+            in >> n;
+            std::vector<HighScoreEntry> entries;
+            for (int i = 0; i < n; i++)
+            {
+                HighScoreEntry e;
+                in >> e.score >> e.level;
+                entries.push_back(e);
+            }
+            allScores[(GameMode)m] = entries;
+        }
+    }
+}
+
+// Just the table of `mode` into `scores`, any vector of HighScoreEntry
+template <typename Vector>
+inline void loadHighScores(GameMode mode, Vector &scores)
+{
+    scores.clear();
+    std::ifstream in("HighScores.txt");
+    std::string tag;
+    while (in >> tag)
+    {
+        if (tag != "MODE")
+            continue;
+        int m, n;
+        if (!(in >> m >> n))
+            return;
+        for (int i = 0; i < n; i++)
+        {
+            HighScoreEntry e;
+            in >> e.score >> e.level;
+            if (m == mode)
+                scores.push_back(e);
+        }
+    }
+}
+
+inline void saveHighScores(const std::map<GameMode, std::vector<HighScoreEntry>> &allScores)
+{
+    std::ofstream out("HighScores.txt");
+    if (!out.is_open())
+        return;
+    for (auto &kv : allScores)
+    {
+        GameMode mode = kv.first;
+        const auto &scores = kv.second;
+        out << "MODE " << (int)mode << "\n";
+        out << scores.size() << "\n";
+        for (auto &e : scores)
+        {
+            out << e.score << " " << e.level << "\n";
+        }
+    }
+}
+
+inline void addHighScore(int score, int level, GameMode mode)
+{
+    std::map<GameMode, std::vector<HighScoreEntry>> allScores;
+    loadHighScores(allScores);
+
+    auto &scores = allScores[mode];
+    scores.push_back({score, level});
+
+    // Sắp xếp giảm dần theo score
+    std::sort(scores.begin(), scores.end(), [](auto &a, auto &b)
+              { return a.score > b.score; });
+
+    if (scores.size() > 5)
+        scores.resize(5);
+
+    saveHighScores(allScores);
+}
+
+// Stress mode never gets less room than the normal modes
+inline Capacities capacitiesFor(GameMode mode, const Capacities &base)
+{
+    if (mode != MODE_STRESS)
+        return base;
+    Capacities c;
+    c.enemies = std::max(base.enemies, STRESS_CAPACITIES.enemies);
+    c.pBullets = std::max(base.pBullets, STRESS_CAPACITIES.pBullets);
+    c.eBullets = std::max(base.eBullets, STRESS_CAPACITIES.eBullets);
+    c.items = std::max(base.items, STRESS_CAPACITIES.items);
+    c.explosions = std::max(base.explosions, STRESS_CAPACITIES.explosions);
+    c.pickupEffects = std::max(base.pickupEffects, STRESS_CAPACITIES.pickupEffects);
+    return c;
+}
+
+// What stepEnemies found in one archetype, plus its scratch
+struct EnemyStep
+{
+    std::vector<int> crashed; // rows that flew into a player...
+    std::vector<int> victims; // ...and which player each hit
+    std::vector<int> movers;  // rows out of the formation...
+    std::vector<sf::Vector2f> moved; // ...and where they moved to
+};
+
+// Things World::timers has due at some tick
+enum TimedKind
+{
+    TIMED_FIRE,      // an enemy's or boss's cooldown ran out
+    TIMED_FLASH_END, // its hit flash goes out
+    TIMED_DIVE,      // a random enemy may dive
+    TIMED_SPAWN,     // survival: the next single enemy
+    TIMED_BOSS       // survival: the next boss
+};
+
+// Enemy events name the entity and are dropped once it is gone. World
+// events carry the timer epoch they were scheduled in (see armTimers).
+struct TimedEvent
+{
+    TimedKind kind;
+    bool boss = false;
+    SlotHandle id;
+};
+
+// How long an enemy stays lit after a hit (0.1 s)
+const unsigned HIT_FLASH_TICKS = 6;
+
+// The entities plus the game state a tick reads and writes
+struct World
+{
+    Capacities caps;
+    EnemyRows enemies;
+    BossRows bosses;
+    BulletRows pBullets;
+    BulletRows eBullets;
+    ItemRows items;
+    ExplosionRows explosions;
+    RingRows pickupEffects;
+    Player player;
+    Player player2; // co-op only
+    bool coop = false;
+    int level = 1;
+    int score = 0;
+    GameMode mode = MODE_NORMAL;
+    Formation formation;
+    float bossSpinAngle = 0.f;
+
+    // Survival mode
+    float survivalTimer = 0.f;
+    int lastBossSpawn = -1;
+
+    // Cooldowns and scheduled game events, by tick (see armTimers)
+    TimerWheel<TimedEvent> timers;
+    std::vector<TimedEvent> due; // this tick's events
+    int armedMode = -1;          // mode they were scheduled for; -1 after a reset
+    unsigned timerEpoch = 0;
+
+    // Every random roll of the simulation comes from here, so a seed
+    // replays the same game and worlds on different threads don't interfere
+    std::minstd_rand rng;
+
+    // Per-tick scratch for the parallel passes, one slot per row
+    std::vector<int> pBulletHits;
+    EnemyStep enemyStep;
+    EnemyStep bossStep;
+};
+
+// Stand-in for std::rand() that only touches this world
+inline int worldRand(World &w)
+{
+    return (int)(w.rng() >> 16); // 0..32767 like RAND_MAX on Windows
+}
+
+// Ships in the game: player, then player2 in co-op
+inline int playerCount(const World &w) { return w.coop ? 2 : 1; }
+inline Player &playerAt(World &w, int i) { return i == 0 ? w.player : w.player2; }
+inline const Player &playerAt(const World &w, int i) { return i == 0 ? w.player : w.player2; }
+
+// In co-op a ship at 0 HP is out until the game ends; alone, 0 HP ends the
+// game after the tick, so the player stays in for the rest of that tick
+inline bool inPlay(const World &w, const Player &p) { return !w.coop || p.hp > 0; }
+
+// Every ship is down: game over
+inline bool playersDown(const World &w)
+{
+    for (int i = 0; i < playerCount(w); ++i)
+        if (playerAt(w, i).hp > 0)
+            return false;
+    return true;
+}
+
+// First ship in play that a circle at `pos` touches, or -1
+inline int touchedPlayer(const World &w, const sf::Vector2f &pos, float radius)
+{
+    for (int i = 0; i < playerCount(w); ++i)
+    {
+        const Player &p = playerAt(w, i);
+        if (inPlay(w, p) && circleHit(pos, radius, p.pos, p.radius))
+            return i;
+    }
+    return -1;
+}
+
+// Events each timer wheel slot has room for before it grows
+const int TIMER_SLOT_RESERVE = 32;
+
+// Empty every archetype and size the tick scratch with room for `caps`.
+// The enemy columns grow in survival mode.
+inline void carveWorld(World &w, const Capacities &caps)
+{
+    w.caps = caps;
+    w.enemies.init(caps.enemies);
+    w.bosses.init(std::max(1, caps.enemies / 8));
+    w.pBullets.init(caps.pBullets);
+    w.eBullets.init(caps.eBullets);
+    w.items.init(caps.items);
+    w.explosions.init(caps.explosions);
+    w.pickupEffects.init(caps.pickupEffects);
+    w.timers.reserve(TIMER_SLOT_RESERVE);
+    // At most one entry per row, and survival grows past caps.enemies
+    for (EnemyStep *step : {&w.enemyStep, &w.bossStep})
+    {
+        const int rows = std::max(caps.enemies, SURVIVAL_MAX_ENEMIES);
+        step->crashed.reserve(rows);
+        step->victims.reserve(rows);
+        step->movers.reserve(rows);
+        step->moved.reserve(rows);
+    }
+    w.pBulletHits.assign(caps.pBullets, -1);
+}
+
+// Live enemies the current mode allows; bosses have the same limit of their own
+inline int enemyLimit(const World &w)
+{
+    return w.mode == MODE_SURVIVAL ? std::max(w.caps.enemies, SURVIVAL_MAX_ENEMIES) : w.caps.enemies;
+}
+
+// Queue `e` as an enemy or a boss; false when the mode's limit is reached.
+// It joins the formation on its first tick; its first shot is scheduled
+// when it is flushed in (see flushEnemies).
+inline bool addEnemy(World &w, const Enemy &e)
+{
+    Bob bob{e.t};
+    Weapon weapon{w.timers.now() + ticksFor(e.fireCD)};
+    Dive dive;
+    dive.attackMode = e.attackMode;
+    dive.returning = e.returning;
+    dive.attackTimer = e.attackTimer;
+    Body body{e.radius};
+    Health health{e.hp, e.maxHp};
+    Rank rank{e.gridX, e.gridY, false};
+    if (e.boss)
+        return w.bosses.spawn(enemyLimit(w), e.pos, e.basePos, bob, weapon, HitFlash(), dive, body, health, rank,
+                              BossBrain{e.bossType, e.phase});
+    return w.enemies.spawn(enemyLimit(w), e.pos, e.basePos, bob, weapon, HitFlash(), dive, body, health, rank);
+}
+
+// Apply the queued enemy and boss commands, and put the first shot of each
+// newcomer on the timers
+template <typename Rows>
+inline void flushEnemyRows(World &w, Rows &rows, bool boss)
+{
+    const int first = rows.flush();
+    const Weapon *weapon = rows.template column<Weapon>();
+    for (int i = first; i < rows.size(); ++i)
+        w.timers.schedule(weapon[i].readyTick, {TIMED_FIRE, boss, rows.id(i)});
+}
+
+inline void flushEnemies(World &w)
+{
+    flushEnemyRows(w, w.enemies, false);
+    flushEnemyRows(w, w.bosses, true);
+}
+
+// Standing in the formation rather than diving or flying back to it
+inline bool isFormationMember(const Dive &d)
+{
+    return !d.attackMode && !d.returning;
+}
+
+// Brings the formation's count up to date with one enemy. Run for every
+// enemy once per tick, on one thread, so joins and leaves stay in order.
+inline void syncFormation(Formation &f, const Dive &dive, Rank &rank, const BasePos &base, float radius)
+{
+    bool member = isFormationMember(dive);
+    if (member == rank.inFormation)
+        return;
+    if (member)
+        f.join(base.x, radius);
+    else
+        f.leave(base.x);
+    rank.inFormation = member;
+}
+
+template <typename Rows>
+inline void rejoinFormation(Formation &f, Rows &rows)
+{
+    const Body *body = rows.template column<Body>();
+    const Dive *dive = rows.template column<Dive>();
+    const BasePos *base = rows.template column<BasePos>();
+    Rank *rank = rows.template column<Rank>();
+    for (int i = 0; i < rows.size(); ++i)
+    {
+        rank[i].inFormation = false;
+        syncFormation(f, dive[i], rank[i], base[i], body[i].radius);
+    }
+}
+
+// Start the formation over from the enemies as they stand, e.g. after
+// loading a save, where every position is a base position
+inline void rebuildFormation(World &w)
+{
+    w.formation.reset();
+    rejoinFormation(w.formation, w.enemies);
+    rejoinFormation(w.formation, w.bosses);
+}
+
+// Queue an enemy or boss row's despawn. It leaves the formation right away
+// and must not be synced again before the flush.
+template <typename Rows>
+inline void despawnEnemy(World &w, Rows &rows, int row)
+{
+    Rank &rank = rows.template column<Rank>()[row];
+    if (rank.inFormation)
+        w.formation.leave(rows.template column<BasePos>()[row].x);
+    rank.inFormation = false;
+    rows.despawn(row);
+}
+
+// Seconds until a cooldown that ends at `tick`, as the save format keeps it
+inline float secondsUntil(unsigned tick, unsigned now)
+{
+    return std::max(0, (int)(tick - now)) * TICK_SECONDS;
+}
+
+inline void saveEnemyRows(std::ostream &out, const EnemyRows &rows, unsigned now)
+{
+    const Health *health = rows.column<Health>();
+    const Weapon *weapon = rows.column<Weapon>();
+    const Dive *dive = rows.column<Dive>();
+    const BasePos *base = rows.column<BasePos>();
+    for (int i = 0; i < rows.size(); ++i)
+        out << "1 0 0 1 " << health[i].hp << " " << base[i].x << " " << base[i].y << " " << (dive[i].attackMode ? 1 : 0) << " " << (dive[i].returning ? 1 : 0) << " " << secondsUntil(weapon[i].readyTick, now) << "\n";
+}
+
+inline void saveBossRows(std::ostream &out, const BossRows &rows, unsigned now)
+{
+    const Health *health = rows.column<Health>();
+    const Weapon *weapon = rows.column<Weapon>();
+    const Dive *dive = rows.column<Dive>();
+    const BasePos *base = rows.column<BasePos>();
+    const BossBrain *brain = rows.column<BossBrain>();
+    for (int i = 0; i < rows.size(); ++i)
+        out << "1 1 " << brain[i].bossType << " " << brain[i].phase << " " << health[i].hp << " " << base[i].x << " " << base[i].y << " " << (dive[i].attackMode ? 1 : 0) << " " << (dive[i].returning ? 1 : 0) << " " << secondsUntil(weapon[i].readyTick, now) << "\n";
+}
+
+inline void saveGame(const World &w, int slot)
+{
+    std::ofstream out("Save" + std::to_string(slot) + ".txt");
+    if (!out.is_open())
+        return;
+
+    // Header
+    out << "LEVEL " << w.level << "\n";
+    out << "SCORE " << w.score << "\n";
+
+    // Player: hp damage pos.x pos.y style
+    out << "PLAYER " << w.player.hp << " " << w.player.damage << " "
+        << w.player.pos.x << " " << w.player.pos.y << " " << (int)w.player.style << "\n";
+
+    // Enemies, then bosses
+    out << "ENEMIES " << w.enemies.size() + w.bosses.size() << "\n";
+    saveEnemyRows(out, w.enemies, w.timers.now());
+    saveBossRows(out, w.bosses, w.timers.now());
+
+    // Items
+    out << "ITEMS " << w.items.size() << "\n";
+    const Position *itemPos = w.items.column<Position>();
+    const Pickup *pickup = w.items.column<Pickup>();
+    for (int i = 0; i < w.items.size(); ++i)
+        out << "1 " << (int)pickup[i].type << " " << itemPos[i].x << " " << itemPos[i].y << "\n";
+
+    out.close();
+}
+
+inline bool loadGame(World &w, int slot)
+{
+    std::ifstream in("Save" + std::to_string(slot) + ".txt");
+    if (!in.is_open())
+        return false;
+
+    std::string tag;
+    // LEVEL
+    in >> tag;
+    if (tag != "LEVEL")
+        return false;
+    in >> w.level;
+
+    // SCORE
+    in >> tag;
+    if (tag != "SCORE")
+        return false;
+    in >> w.score;
+
+    // PLAYER
+    in >> tag;
+    if (tag != "PLAYER")
+        return false;
+    int styleInt;
+    in >> w.player.hp >> w.player.damage >> w.player.pos.x >> w.player.pos.y >> styleInt;
+    w.player.style = (ShootingStyle)styleInt;
+
+    // ENEMIES
+    int enemyCount = 0;
+    in >> tag;
+    if (tag != "ENEMIES")
+        return false;
+    in >> enemyCount;
+
+    // Records past what the mode can hold are read and dropped
+    w.enemies.clear();
+    w.bosses.clear();
+    for (int i = 0; i < enemyCount; ++i)
+    {
+        Enemy e;
+        int activeInt, bossInt;
+        in >> activeInt >> bossInt >> e.bossType >> e.phase >> e.hp >> e.pos.x >> e.pos.y;
+        int attackModeInt, returningInt;
+        in >> attackModeInt >> returningInt >> e.fireCD;
+        e.boss = (bossInt != 0);
+        e.attackMode = (attackModeInt != 0);
+        e.returning = (returningInt != 0);
+        e.basePos = e.pos;
+        e.t = 0.f;
+
+        if (e.boss)
+            e.radius = 50.f;
+        else
+            e.radius = 26.f;
+        if (activeInt != 0 && e.hp > 0)
+            addEnemy(w, e);
+    }
+    flushEnemies(w);
+
+    // ITEMS
+    int itemCount = 0;
+    in >> tag;
+    if (tag != "ITEMS")
+        return false;
+    in >> itemCount;
+    w.items.clear();
+    for (int i = 0; i < itemCount; ++i)
+    {
+        int activeInt, typeInt;
+        sf::Vector2f pos;
+        in >> activeInt >> typeInt >> pos.x >> pos.y;
+        if (activeInt != 0 && typeInt >= 0)
+            w.items.spawn(w.caps.items, pos, Pickup{(ItemType)typeInt});
+    }
+    w.items.flush();
+
+    in.close();
+
+    w.pBullets.clear();
+    w.eBullets.clear();
+    rebuildFormation(w);
+
+    return true;
+}
+
+inline void fireEnemyBullet(World &w, const sf::Vector2f &pos, float radius)
+{
+    int level = w.level;
+
+    // Damage scale by level
+    int dmg = 1 + 2 * level;
+
+    if (dmg > 64)
+        dmg = 64;
+
+    // Dropped once the pool is full
+    auto spawnBullet = [&](sf::Vector2f vel)
+    {
+        w.eBullets.spawn(w.caps.eBullets, pos + sf::Vector2f(0.f, radius + 10.f), vel, Damage{dmg});
+    };
+
+    if (w.mode == MODE_STRESS)
+    {
+        for (int dx = -2; dx <= 2; dx++)
+            spawnBullet({dx * 60.f, tuning.eBulletSpeed});
+        return;
+    }
+
+    spawnBullet({0.f, tuning.eBulletSpeed});
+}
+
+// One volley of boss `row`, by its type and phase
+inline void fireBossBullet(World &w, int row)
+{
+    const sf::Vector2f pos = w.bosses.column<Position>()[row];
+    const float radius = w.bosses.column<Body>()[row].radius;
+    const BossBrain &e = w.bosses.column<BossBrain>()[row];
+    Dive &dive = w.bosses.column<Dive>()[row];
+    int level = w.level;
+
+    int dmg = 4 + 2 * level;
+    if (dmg > 64)
+        dmg = 64;
+
+    // helper spawn bullet; dropped once the pool is full
+    auto spawnBullet = [&](sf::Vector2f vel)
+    {
+        w.eBullets.spawn(w.caps.eBullets, pos + sf::Vector2f(0.f, radius + 10.f), vel, Damage{dmg});
+    };
+
+    switch (e.bossType)
+    {
+    case 0: // Shooter Boss
+        if (e.phase == 1)
+        {
+            spawnBullet({0.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 2)
+        {
+
+            spawnBullet({0.f, tuning.eBulletSpeed});
+            spawnBullet({-60.f, tuning.eBulletSpeed});
+            spawnBullet({60.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 3)
+        {
+
+            for (int dx = -2; dx <= 2; dx++)
+                spawnBullet({dx * 40.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 4)
+        {
+            // spam 8 viên theo vòng
+            for (int i = 0; i < 8; i++)
+            {
+                float angle = w.bossSpinAngle + i * 3.14159f / 4.f;
+                spawnBullet({std::cos(angle) * tuning.eBulletSpeed, std::sin(angle) * tuning.eBulletSpeed});
+            }
+            w.bossSpinAngle += 0.2f;
+        }
+        break;
+    case 1: // Spread Boss
+        if (e.phase == 1)
+        {
+
+            spawnBullet({0.f, tuning.eBulletSpeed});
+            spawnBullet({-100.f, tuning.eBulletSpeed});
+            spawnBullet({100.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 2)
+        {
+
+            for (int dx = -2; dx <= 2; dx++)
+                spawnBullet({dx * 80.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 3)
+        {
+            // bắn 2 vòng đạn chéo
+            for (int i = -3; i <= 3; i++)
+            {
+                spawnBullet({i * 60.f, tuning.eBulletSpeed});
+            }
+        }
+        else if (e.phase == 4)
+        {
+            // bắn theo hình quạt rộng
+            for (int i = -5; i <= 5; i++)
+            {
+                spawnBullet({i * 50.f, tuning.eBulletSpeed});
+            }
+        }
+        break;
+    case 2: // Summoner Boss
+        if (e.phase == 1)
+        {
+            spawnBullet({0.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 2)
+        {
+            spawnBullet({-80.f, tuning.eBulletSpeed});
+            spawnBullet({80.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 3)
+        {
+            // bắn + gọi thêm enemy nhỏ
+            spawnBullet({0.f, tuning.eBulletSpeed});
+            Enemy minion;
+            minion.pos = pos + sf::Vector2f((worldRand(w) % 100) - 50, 40.f);
+            minion.basePos = minion.pos - w.formation.offset;
+            minion.hp = 6 + level;
+            minion.radius = 18.f;
+            minion.fireCD = tuning.enemyFireBaseCooldown + (worldRand(w) % 100) / 100.f;
+            addEnemy(w, minion);
+        }
+        else if (e.phase == 4)
+        {
+            // vừa summon vừa spam spread
+            for (int dx = -2; dx <= 2; dx++)
+                spawnBullet({dx * 70.f, tuning.eBulletSpeed});
+            for (int i = 0; i < 2; i++)
+            {
+                // Succeeds as often as a random slot of the pool is free
+                if (worldRand(w) % enemyLimit(w) >= w.enemies.size() + w.enemies.pending())
+                {
+                    Enemy minion;
+                    minion.pos = pos + sf::Vector2f((worldRand(w) % 200) - 100, 50.f);
+                    minion.basePos = minion.pos - w.formation.offset;
+                    minion.hp = 8 + level;
+                    minion.radius = 20.f;
+                    minion.fireCD = tuning.enemyFireBaseCooldown + (worldRand(w) % 100) / 100.f;
+                    addEnemy(w, minion);
+                }
+            }
+        }
+        break;
+    case 3: // Charger Boss
+        if (e.phase == 1)
+            spawnBullet({0.f, tuning.eBulletSpeed});
+        else if (e.phase == 2)
+        {
+            spawnBullet({-100.f, tuning.eBulletSpeed});
+            spawnBullet({100.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 3)
+        {
+            // bắn + chuẩn bị lao xuống
+            spawnBullet({0.f, tuning.eBulletSpeed});
+            if (!dive.attackMode)
+            {
+                dive.attackMode = true;
+                dive.attackTimer = 0.f;
+            }
+        }
+        else if (e.phase == 4)
+        {
+            // spam spread nhanh
+            for (int dx = -3; dx <= 3; dx++)
+                spawnBullet({dx * 70.f, tuning.eBulletSpeed});
+            if (!dive.attackMode)
+            {
+                dive.attackMode = true;
+                dive.attackTimer = 0.f;
+            }
+        }
+        break;
+
+    case 4: // Laser Boss
+        if (e.phase == 1)
+        {
+            spawnBullet({0.f, tuning.eBulletSpeed});
+        }
+        else if (e.phase == 2)
+        {
+            // 2 laser
+
+            spawnBullet({0.f, tuning.eBulletSpeed * 1.5f});
+            spawnBullet({0.f, tuning.eBulletSpeed * 1.2f});
+        }
+        else if (e.phase == 3)
+        {
+            // Laser
+
+            for (int i = -2; i <= 2; i++)
+                spawnBullet({i * 20.f, tuning.eBulletSpeed * 1.5f});
+        }
+        else if (e.phase == 4)
+        {
+            // Laser
+
+            for (int i = -6; i <= 6; i++)
+                spawnBullet({i * 40.f, tuning.eBulletSpeed * 1.6f});
+        }
+        break;
+    }
+}
+
+// Bullet integration: move rows [begin, end) and despawn the ones that left the screen
+inline void moveBullets(BulletRows &bullets, int begin, int end, float dt)
+{
+    Position *pos = bullets.column<Position>();
+    const Velocity *vel = bullets.column<Velocity>();
+    for (int i = begin; i < end; ++i)
+    {
+        pos[i] += vel[i] * dt;
+        if (pos[i].y > WINDOW_HEIGHT + 40.f || pos[i].x < -40.f ||
+            pos[i].x > WINDOW_WIDTH + 40.f || pos[i].y < -40.f)
+            bullets.despawn(i);
+    }
+}
+
+// Fresh wave (or boss) for `lvl` in the current mode
+inline void spawnEnemy(World &w, int lvl)
+{
+    w.enemies.clear();
+    w.bosses.clear();
+    w.formation.reset();
+
+    if (w.mode == MODE_HARD)
+    {
+        if (lvl % 5 == 0)
+        {
+            Enemy e;
+            e.boss = true;
+            e.pos = {WINDOW_WIDTH / 2.f, 120.f};
+            e.basePos = e.pos;
+            e.t = 0.f;
+            e.radius = 36.f;
+            e.maxHp = 60 + 30 * lvl;
+            e.hp = e.maxHp;
+            if (lvl == 5)
+                e.bossType = 0;
+            else if (lvl == 10)
+                e.bossType = 1;
+            else if (lvl == 15)
+                e.bossType = 2;
+            else if (lvl == 20)
+                e.bossType = 3;
+            else if (lvl == 25)
+                e.bossType = 4;
+            else // lvl >= 30
+                e.bossType = ((lvl / 5) - 1) % 5;
+            e.fireCD = tuning.enemyFireBaseCooldown * 0.4f;
+            e.attackMode = false;
+            e.attackTimer = 0.f;
+            addEnemy(w, e);
+        }
+        else
+        {
+            for (int r = 0; r < FORM_ROWS; r++)
+            {
+                for (int c = 0; c < FORM_COLS; c++)
+                {
+                    Enemy e;
+                    e.basePos = e.pos;
+                    e.gridX = c;
+                    e.gridY = r;
+                    e.t = static_cast<float>((r * 17 + c * 13) % 100) * 0.01f;
+                    e.radius = 26.f;
+                    e.pos = {tuning.formStartX + c * tuning.formGapX, tuning.formStartY + r * tuning.formGapY};
+                    e.basePos = e.pos;
+                    e.hp = std::max(10, 10 + 4 * lvl);
+                    e.fireCD = tuning.enemyFireBaseCooldown + (worldRand(w) % 60) / 100.f;
+                    e.hp *= 2;
+                    // Level 1 fires at level 2's rate, not never
+                    e.fireCD *= (0.7f / std::max(1, lvl / 2));
+                    e.attackMode = false;
+                    e.attackTimer = 0.f;
+                    if (!addEnemy(w, e))
+                        break;
+                }
+            }
+        }
+    }
+    else if (w.mode == MODE_NORMAL)
+    {
+        if (lvl % 5 == 0)
+        {
+            Enemy e;
+            e.boss = true;
+            e.pos = {WINDOW_WIDTH / 2.f, 120.f};
+            e.basePos = e.pos;
+            e.t = 0.f;
+            e.radius = 36.f;
+            e.maxHp = 60 + 20 * lvl;
+            e.hp = e.maxHp;
+            if (lvl == 5)
+                e.bossType = 0;
+            else if (lvl == 10)
+                e.bossType = 1;
+            else if (lvl == 15)
+                e.bossType = 2;
+            else if (lvl == 20)
+                e.bossType = 3;
+            else if (lvl == 25)
+                e.bossType = 4;
+            else // lvl >= 30
+                e.bossType = ((lvl / 5) - 1) % 5;
+            e.fireCD = tuning.enemyFireBaseCooldown * 0.8f;
+            e.attackMode = false;
+            e.attackTimer = 0.f;
+            addEnemy(w, e);
+        }
+        else
+        {
+            for (int r = 0; r < FORM_ROWS; r++)
+            {
+                for (int c = 0; c < FORM_COLS; c++)
+                {
+                    Enemy e;
+                    e.basePos = e.pos;
+                    e.gridX = c;
+                    e.gridY = r;
+                    e.t = static_cast<float>((r * 17 + c * 13) % 100) * 0.01f;
+                    e.radius = 26.f;
+                    e.pos = {tuning.formStartX + c * tuning.formGapX, tuning.formStartY + r * tuning.formGapY};
+                    e.basePos = e.pos;
+                    e.hp = std::max(10, 10 + 4 * lvl);
+                    e.fireCD = tuning.enemyFireBaseCooldown + (worldRand(w) % 60) / 100.f;
+                    e.attackMode = false;
+                    e.attackTimer = 0.f;
+                    if (!addEnemy(w, e))
+                        break;
+                }
+            }
+        }
+    }
+    else if (w.mode == MODE_STRESS)
+    {
+        // Dense, fast-firing grid that keeps the bullet pool near full
+        const float gapX = (WINDOW_WIDTH - 2.f * tuning.formStartX) / STRESS_COLS;
+        const float gapY = 26.f;
+        for (int r = 0; r < STRESS_ROWS; r++)
+        {
+            for (int c = 0; c < STRESS_COLS; c++)
+            {
+                Enemy e;
+                e.gridX = c;
+                e.gridY = r;
+                e.t = static_cast<float>((r * 17 + c * 13) % 100) * 0.01f;
+                e.radius = 12.f;
+                e.pos = {tuning.formStartX + c * gapX, tuning.formStartY * 0.6f + r * gapY};
+                e.basePos = e.pos;
+                e.hp = 4 + lvl;
+                e.fireCD = tuning.enemyFireBaseCooldown * 0.1f + (worldRand(w) % 40) / 100.f;
+                e.attackMode = false;
+                e.attackTimer = 0.f;
+                if (!addEnemy(w, e))
+                    break;
+            }
+        }
+    }
+
+    flushEnemies(w);
+}
+
+// New game in the current mode, keeping the pools and the random stream
+inline void resetGame(World &w)
+{
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        Player &player = playerAt(w, i);
+        player.hp = 100;
+        player.damage = 2;
+        player.style = SINGLE;
+        player.canShoot = true;
+        player.pos = {WINDOW_WIDTH / 2.f, WINDOW_HEIGHT - 70.0f}; // Reset vị trí
+        // Side by side in co-op
+        if (w.coop)
+            player.pos.x = WINDOW_WIDTH * (i == 0 ? 1.f : 2.f) / 3.f;
+    }
+    w.level = 1;
+    w.score = 0;
+    w.bossSpinAngle = 0.f;
+    // Before the new wave, so its first shots are the only timers left
+    w.timers.clear();
+    w.armedMode = -1;
+
+    spawnEnemy(w, w.level);
+
+    // Clear
+    w.eBullets.clear();
+    w.pBullets.clear();
+    w.items.clear();
+    w.survivalTimer = 0.f;
+    w.lastBossSpawn = -1;
+}
+
+inline void dropItemAt(World &w, const sf::Vector2f &pos)
+{
+    if ((worldRand(w) % 100) < tuning.dropChancePercent)
+    {
+        ItemType type;
+        int r = worldRand(w) % 20; // 4 loại item
+        if (r < 7)
+            type = ITEM_DMG;
+        else if (r < 14 && r >= 7)
+            type = ITEM_SINGLE;
+        else if (r <= 16 && r >= 14)
+            type = ITEM_DOUBLE;
+        else if (r <= 18 && r > 16)
+            type = ITEM_SPREAD;
+        else
+            type = HEAL;
+        w.items.spawn(w.caps.items, pos, Pickup{type});
+    }
+}
+
+// False when every explosion slot is busy
+inline bool triggerExplosion(World &w, const sf::Vector2f &pos)
+{
+    return w.explosions.spawn(w.caps.explosions, pos, ExplosionFrame());
+}
+
+inline bool triggerPickupEffect(World &w, const sf::Vector2f &pos, const sf::Color &color)
+{
+    return w.pickupEffects.spawn(w.caps.pickupEffects, pos, Ring{10.f, 255.f, color});
+}
+
+// ---------------------------------------------------------------------------
+// One PLAYING tick.
+//
+// The heavy passes (bullet integration, collision tests, effect aging) run
+// as JobSystem chunks that only touch their own rows and write
+// what happened into per-row scratch. Anything with an order (damage to the
+// player, kills, score, item drops, new bullets, worldRand) is applied after
+// each pass on this thread in row order, so a tick gives the same result on
+// any number of threads. Enemy movement runs on this thread through the SIMD
+// kernels in EnemyKernels.hpp. Cooldowns and timed events come off
+// World::timers, which hands out only what is due this tick. Each system
+// flushes the spawns and despawns it queued before it returns.
+
+// Below these sizes a pass runs inline; the normal modes never pay for threads
+const int BULLET_GRAIN = 512;
+const int EFFECT_GRAIN = 128;
+// Bullet-vs-enemy tests per collision chunk
+const int HIT_TESTS_PER_JOB = 16384;
+
+// What one player did during this tick
+struct TickInput
+{
+    float moveDir = 0.f;      // -1 left, 1 right; in between if held for part of the tick
+    bool fire = false;        // fire key down at the end of the tick
+    bool firePressed = false; // fire key went down during the tick, even if already released
+};
+
+// Sounds a tick asks for; the game plays them, headless runs ignore them
+struct TickEvents
+{
+    bool shot = false;
+    bool explosion = false;
+    bool pickup = false;
+    bool crash = false;
+    bool hit = false;
+    bool death = false;
+    int damageTaken = 0; // HP the players lost, for the balance runner
+};
+
+inline void damagePlayer(World &w, Player &player, int dmg, TickEvents &ev)
+{
+    ev.damageTaken += std::min(dmg, player.hp);
+    player.hp -= dmg;
+    if (player.hp < 0)
+    {
+        player.hp = 0;
+        ev.death = playersDown(w);
+    }
+}
+
+inline bool spawnPlayerBullet(World &w, const Player &player, const sf::Vector2f &pos, const sf::Vector2f &vel)
+{
+    return w.pBullets.spawn(w.caps.pBullets, pos, vel, Damage{player.damage});
+}
+
+inline void updatePlayer(World &w, Player &player, const TickInput &in, float dt, TickEvents &ev)
+{
+    if (!inPlay(w, player))
+        return;
+    player.pos.x += in.moveDir * tuning.playerSpeed * dt;
+    if (player.pos.x < player.radius)
+        player.pos.x = player.radius;
+    if (player.pos.x > WINDOW_WIDTH - player.radius)
+        player.pos.x = WINDOW_WIDTH - player.radius;
+
+    // One volley per press of Space. Stress mode fires every tick it is held.
+    if (w.mode == MODE_STRESS)
+        player.canShoot = true;
+    bool shoot = in.firePressed || (in.fire && player.canShoot);
+    player.canShoot = !in.fire;
+    if (!shoot)
+        return;
+
+    const sf::Vector2f up(0.f, -tuning.pBulletSpeed); // thẳng lên
+    if (player.style == SINGLE)
+    {
+        ev.shot |= spawnPlayerBullet(w, player, player.pos - sf::Vector2f(0.f, player.radius + 8.f), up);
+    }
+    else if (player.style == DOUBLE)
+    {
+        // 2 rows of bullets
+        ev.shot |= spawnPlayerBullet(w, player, player.pos + sf::Vector2f(-15.f, -player.radius - 8.f), up);
+        spawnPlayerBullet(w, player, player.pos + sf::Vector2f(15.f, -player.radius - 8.f), up);
+    }
+    else if (player.style == SPREAD)
+    {
+        sf::Vector2f basePos = player.pos - sf::Vector2f(0.f, player.radius + 8.f);
+        ev.shot |= spawnPlayerBullet(w, player, basePos, up);                // Straight
+        spawnPlayerBullet(w, player, basePos, up + sf::Vector2f(-120.f, 0.f)); // lệch trái
+        spawnPlayerBullet(w, player, basePos, up + sf::Vector2f(120.f, 0.f));  // lệch phải
+    }
+    w.pBullets.flush();
+}
+
+// Hit tests see enemies and bosses as one list: the enemy rows, then the
+// boss rows. Of those not already marked to despawn, the one a bullet
+// moving from `from` by `move` touches first, or -1. A tie goes to the
+// lower index.
+inline int earliestEnemyHit(const World &w, const sf::Vector2f &from, const sf::Vector2f &move)
+{
+    int best = -1;
+    float bestT = 2.f;
+    // Nothing outside the circle around the whole move can be touched, and
+    // that test costs no more than circleHit
+    const sf::Vector2f mid = from + move * 0.5f;
+    const float reach = std::sqrt(move.x * move.x + move.y * move.y) * 0.5f + BULLET_RADIUS;
+    auto scan = [&](const auto &rows, int base)
+    {
+        const Position *pos = rows.template column<Position>();
+        const Body *body = rows.template column<Body>();
+        for (int i = 0; i < rows.size(); ++i)
+        {
+            if (!circleHit(mid, reach, pos[i], body[i].radius))
+                continue;
+            float t = sweptCircleHit(from, move, BULLET_RADIUS, pos[i], body[i].radius);
+            if (t >= 0.f && t < bestT && !rows.despawning(i))
+            {
+                bestT = t;
+                best = base + i;
+            }
+        }
+    };
+    scan(w.enemies, 0);
+    scan(w.bosses, w.enemies.size());
+    return best;
+}
+
+// One bullet's worth of damage to an enemy or boss row; a kill drops an
+// item, explodes and scores `points`
+template <typename Rows>
+inline void hitEnemy(World &w, Rows &rows, int row, int dmg, int points, TickEvents &ev)
+{
+    Health &health = rows.template column<Health>()[row];
+    health.hp -= dmg;
+    // A hit while lit only pushes the end back; the pending event sees that
+    HitFlash &flash = rows.template column<HitFlash>()[row];
+    const unsigned end = w.timers.now() + HIT_FLASH_TICKS;
+    if (flash.endTick == 0)
+        w.timers.schedule(end, {TIMED_FLASH_END, std::is_same<Rows, BossRows>::value, rows.id(row)});
+    flash.endTick = end;
+    if (health.hp <= 0)
+    {
+        const sf::Vector2f pos = rows.template column<Position>()[row];
+        dropItemAt(w, pos);
+        ev.explosion |= triggerExplosion(w, pos);
+        w.score += points;
+        despawnEnemy(w, rows, row);
+    }
+}
+
+inline void updatePlayerBullets(World &w, float dt, JobSystem &jobs, TickEvents &ev)
+{
+    BulletRows &bullets = w.pBullets;
+    jobs.parallelFor(bullets.size(), BULLET_GRAIN, [&](int begin, int end)
+                     { moveBullets(bullets, begin, end, dt); });
+    bullets.flush();
+
+    // Which enemy each bullet would hit first over the tick's move, against
+    // the enemies as they are now
+    const int count = bullets.size();
+    const int enemyCount = w.enemies.size();
+    const Position *pos = bullets.column<Position>();
+    const Velocity *vel = bullets.column<Velocity>();
+    int grain = std::max(1, HIT_TESTS_PER_JOB / std::max(1, enemyCount + w.bosses.size()));
+    jobs.parallelFor(count, grain, [&](int begin, int end)
+                     {
+                         for (int i = begin; i < end; ++i)
+                             w.pBulletHits[i] = earliestEnemyHit(w, pos[i] - vel[i] * dt, vel[i] * dt); });
+
+    // Apply the hits in bullet order. If an earlier bullet already killed the
+    // target, look again among the ones left, exactly as a one-by-one loop would.
+    auto killed = [&](int ei)
+    { return ei < enemyCount ? w.enemies.despawning(ei) : w.bosses.despawning(ei - enemyCount); };
+    const Damage *damage = bullets.column<Damage>();
+    for (int i = 0; i < count; ++i)
+    {
+        int ei = w.pBulletHits[i];
+        if (ei >= 0 && killed(ei))
+            ei = earliestEnemyHit(w, pos[i] - vel[i] * dt, vel[i] * dt);
+        if (ei < 0)
+            continue;
+
+        bullets.despawn(i);
+        if (ei < enemyCount)
+            hitEnemy(w, w.enemies, ei, damage[i].value, 10, ev);
+        else
+            hitEnemy(w, w.bosses, ei - enemyCount, damage[i].value, 150, ev);
+    }
+    bullets.flush();
+    flushEnemies(w);
+    w.items.flush();
+    w.explosions.flush();
+}
+
+inline int bossPhase(const Health &h)
+{
+    float hpPercent = (float)h.hp / (float)h.maxHp;
+    if (hpPercent > 0.75f)
+        return 1;
+    else if (hpPercent > 0.5f)
+        return 2;
+    else if (hpPercent > 0.25f)
+        return 3;
+    return 4;
+}
+
+// Speeds along the dive paths and the way back
+const float DIVE_SPEED = 300.f;
+const float RETURN_SPEED = 200.f;
+
+// Dives, returns and drifting of one enemy out of the formation. Bosses
+// don't dive (`dives` false), but a charger boss in attack mode drifts like
+// a diver. The player it flew into, or -1.
+inline int moveOutOfFormation(sf::Vector2f &pos, Dive &dive, const BasePos &base, float radius, bool dives,
+                              const World &w, float dt)
+{
+    const Formation &formation = w.formation;
+    const DivePaths &paths = divePaths();
+    if (dives && dive.attackMode)
+    {
+        const BakedPath &path = paths.dives[dive.pattern];
+        if (dive.along < 0.f)
+        {
+            dive.from = pos;
+            dive.along = 0.f;
+        }
+        dive.along += DIVE_SPEED * dt;
+        sf::Vector2f p = path.at(dive.along);
+        if (dive.mirrored)
+            p.x = -p.x;
+        pos = dive.from + p;
+
+        const int victim = touchedPlayer(w, pos, radius);
+        if (victim >= 0)
+            return victim;
+
+        if (pos.y > WINDOW_HEIGHT - 30.f || dive.along >= path.length())
+        {
+            dive.attackMode = false;
+            dive.returning = true;
+            dive.attackTimer = 0.f;
+            dive.along = -1.f;
+        }
+    }
+    if (dive.returning)
+    {
+        sf::Vector2f target = base + formation.offset;
+        if (dive.along < 0.f)
+        {
+            // The one sqrt of the trip: how long it takes at RETURN_SPEED
+            sf::Vector2f d = target - pos;
+            float dist = std::sqrt(d.x * d.x + d.y * d.y) * paths.back.length();
+            dive.from = pos;
+            dive.along = 0.f;
+            dive.rate = dist > 1.f ? RETURN_SPEED / dist : 1.f / dt;
+        }
+        dive.along += dive.rate * dt;
+        if (dive.along >= 1.f)
+        {
+            pos = target;
+            dive.returning = false;
+            dive.along = -1.f;
+        }
+        else
+        {
+            // Stretched onto the line to the slot as it is now, so it lands
+            // on the slot however far the formation moved meanwhile
+            sf::Vector2f d = target - dive.from;
+            sf::Vector2f side(-d.y, d.x);
+            if (dive.mirrored)
+                side = -side;
+            sf::Vector2f b = paths.back.at(dive.along * paths.back.length());
+            pos = dive.from + d * b.x + side * b.y;
+        }
+    }
+    else if (dive.attackMode)
+    {
+        // Divers keep drifting with the block while there is one
+        if (formation.size() > 0)
+        {
+            float dx = formation.dir * tuning.formSpeed * dt;
+            pos.x += dx;
+            dive.from.x += dx;
+        }
+    }
+    else
+    {
+        pos = base + formation.offset;
+    }
+    return -1;
+}
+
+// Movement of every row of `rows`. The few enemies out of the formation are
+// moved one at a time into scratch; then the whole block is placed and
+// bobbed by the kernels, and the movers are put back on top. Fills
+// step.crashed in row order.
+template <typename Rows>
+inline void stepEnemies(const World &w, Rows &rows, bool dives, float dt, EnemyStep &step)
+{
+    const int count = rows.size();
+    Position *pos = rows.template column<Position>();
+    const BasePos *base = rows.template column<BasePos>();
+    Dive *dive = rows.template column<Dive>();
+    const Body *body = rows.template column<Body>();
+
+    step.crashed.clear();
+    step.victims.clear();
+    step.movers.clear();
+    step.moved.clear();
+    for (int i = 0; i < count; ++i)
+    {
+        if (isFormationMember(dive[i]))
+            continue;
+        sf::Vector2f p = pos[i];
+        const int victim = moveOutOfFormation(p, dive[i], base[i], body[i].radius, dives, w, dt);
+        if (victim >= 0)
+        {
+            step.crashed.push_back(i);
+            step.victims.push_back(victim);
+        }
+        step.movers.push_back(i);
+        step.moved.push_back(p);
+    }
+
+    placeInFormation(reinterpret_cast<float *>(pos), reinterpret_cast<const float *>(base), count, w.formation.offset);
+    for (std::size_t k = 0; k < step.movers.size(); ++k)
+        pos[step.movers[k]] = step.moved[k];
+    advancePhases(reinterpret_cast<float *>(rows.template column<Bob>()), count, dt);
+}
+
+// World events are dropped once the world has been armed again since
+inline bool isCurrent(const World &w, const TimedEvent &e)
+{
+    return e.id.generation == w.timerEpoch;
+}
+
+inline TimedEvent worldEvent(const World &w, TimedKind kind)
+{
+    return {kind, false, {-1, w.timerEpoch}};
+}
+
+// Put the next random dive on the timers, `quiet` seconds from now. Instead
+// of a 1 in 300 roll every tick, the wait until the first roll that would
+// hit is drawn once.
+inline void scheduleDive(World &w, float quiet)
+{
+    const double u = (worldRand(w) + 1) / 32769.0;
+    unsigned tick = w.timers.now() + 1 + (unsigned)(std::log(u) / std::log(1.0 - 1.0 / 300));
+    if (quiet > 0.f)
+        tick += ticksFor(quiet);
+    w.timers.schedule(tick, worldEvent(w, TIMED_DIVE));
+}
+
+// Schedule the world events for the mode the world runs in. Runs before the
+// first tick after a reset or a change of mode; the new epoch drops
+// anything an earlier arming left on the timers.
+inline void armTimers(World &w)
+{
+    w.timerEpoch++;
+    w.armedMode = w.mode;
+    scheduleDive(w, 0.f);
+    if (w.mode == MODE_SURVIVAL)
+    {
+        w.timers.schedule(w.timers.now() + ticksFor(2.f), worldEvent(w, TIMED_SPAWN));
+        w.timers.schedule(w.timers.now() + 1, worldEvent(w, TIMED_BOSS));
+    }
+}
+
+// The ship a diver starting at `from` swings toward: the nearest one in play
+inline const Player &diveTarget(const World &w, const sf::Vector2f &from)
+{
+    const Player *target = &w.player;
+    for (int i = 1; i < playerCount(w); ++i)
+    {
+        const Player &p = playerAt(w, i);
+        if (!inPlay(w, *target) || (inPlay(w, p) && std::abs(p.pos.x - from.x) < std::abs(target->pos.x - from.x)))
+            target = &p;
+    }
+    return *target;
+}
+
+// A random enemy standing in the formation dives, on a random pattern that
+// swings toward a player; after a dive the next one waits 1.2 s
+inline void startDive(World &w)
+{
+    EnemyRows &enemies = w.enemies;
+    const int count = enemies.size();
+    Dive *dive = enemies.column<Dive>();
+    const Position *pos = enemies.column<Position>();
+    int start = worldRand(w) % std::max(1, count);
+    for (int k = 0; k < count; ++k)
+    {
+        int i = (start + k) % count;
+        if (isFormationMember(dive[i]))
+        {
+            dive[i].attackMode = true;
+            dive[i].attackTimer = 0.f;
+            dive[i].along = -1.f;
+            dive[i].pattern = (unsigned char)(worldRand(w) % DIVE_PATTERNS);
+            dive[i].mirrored = diveTarget(w, pos[i]).pos.x < pos[i].x;
+            scheduleDive(w, 1.2f);
+            return;
+        }
+    }
+    scheduleDive(w, 0.f);
+}
+
+// Spawn 1 enemy đơn lẻ (không xóa cả mảng); the columns grow as needed
+inline void spawnSurvivalEnemy(World &w)
+{
+    Enemy en;
+    en.gridX = -1;
+    en.gridY = -1;
+    en.t = static_cast<float>((w.enemies.size() * 17 + (worldRand(w) % 100)) % 100) * 0.01f;
+    en.radius = 26.f;
+    float x = 50.f + (worldRand(w) % (WINDOW_WIDTH - 100));
+    en.pos = {x, 80.f}; // spawn từ trên màn hình
+    en.basePos = en.pos - w.formation.offset;
+    en.hp = std::max(6, 6 + (int)(w.survivalTimer / 20.0f)); // tăng hp dần
+    en.fireCD = tuning.enemyFireBaseCooldown + (worldRand(w) % 60) / 100.f;
+    en.attackMode = false;
+    en.attackTimer = 0.f;
+    en.maxHp = en.hp;
+    addEnemy(w, en);
+    float next = std::max(0.5f, 2.f - w.survivalTimer / 30.f); // spawn nhanh dần
+    w.timers.schedule(w.timers.now() + ticksFor(next), worldEvent(w, TIMED_SPAWN));
+}
+
+// Spawn boss mỗi 60s (tăng bossCycle, mỗi mốc một boss)
+inline void spawnSurvivalBoss(World &w)
+{
+    int bossCycle = w.lastBossSpawn + 1;
+    Enemy boss;
+    boss.boss = true;
+    boss.pos = {WINDOW_WIDTH / 2.f, 120.f};
+    boss.basePos = boss.pos - w.formation.offset;
+    boss.t = 0.f;
+    boss.radius = 36.f;
+    boss.maxHp = 80 + 30 * bossCycle; // tăng theo lần boss
+    boss.hp = boss.maxHp;
+    boss.bossType = bossCycle % 5; // tuần tự các type
+    boss.fireCD = tuning.enemyFireBaseCooldown * 0.6f;
+    boss.attackMode = false;
+    boss.attackTimer = 0.f;
+    addEnemy(w, boss);
+
+    w.lastBossSpawn = bossCycle;
+    w.timers.schedule(w.timers.now() + ticksFor(60.f), worldEvent(w, TIMED_BOSS));
+}
+
+// Cooldown of enemy `row` ran out: shoot and start the next one
+inline void enemyFires(World &w, int row)
+{
+    EnemyRows &enemies = w.enemies;
+    fireEnemyBullet(w, enemies.column<Position>()[row], enemies.column<Body>()[row].radius);
+    float cooldown;
+    if (w.mode == MODE_STRESS)
+        cooldown = tuning.enemyFireBaseCooldown * 0.1f + (worldRand(w) % 40) / 100.f;
+    else
+        cooldown = tuning.enemyFireBaseCooldown + (worldRand(w) % 60) / 100.f;
+    Weapon &weapon = enemies.column<Weapon>()[row];
+    weapon.readyTick = w.timers.now() + ticksFor(cooldown);
+    w.timers.schedule(weapon.readyTick, {TIMED_FIRE, false, enemies.id(row)});
+}
+
+// Same for a boss; the later the phase, the shorter the cooldown
+inline void bossFires(World &w, int row)
+{
+    BossRows &bosses = w.bosses;
+    fireBossBullet(w, row);
+    const int phase = bosses.column<BossBrain>()[row].phase;
+    float cooldown;
+    if (phase == 1)
+        cooldown = tuning.enemyFireBaseCooldown * 0.8f;
+    else if (phase == 2)
+        cooldown = tuning.enemyFireBaseCooldown * 0.7f;
+    else if (phase == 3)
+        cooldown = tuning.enemyFireBaseCooldown * 0.6f;
+    else
+        cooldown = tuning.enemyFireBaseCooldown * 0.5f;
+    Weapon &weapon = bosses.column<Weapon>()[row];
+    weapon.readyTick = w.timers.now() + ticksFor(cooldown);
+    w.timers.schedule(weapon.readyTick, {TIMED_FIRE, true, bosses.id(row)});
+}
+
+// The hit flash goes out, unless a later hit pushed its end back
+template <typename Rows>
+inline void endHitFlash(World &w, Rows &rows, int row, bool boss)
+{
+    HitFlash &flash = rows.template column<HitFlash>()[row];
+    if ((int)(flash.endTick - w.timers.now()) > 0)
+        w.timers.schedule(flash.endTick, {TIMED_FLASH_END, boss, rows.id(row)});
+    else
+        flash.endTick = 0;
+}
+
+inline void updateEnemies(World &w, float dt, TickEvents &ev)
+{
+    EnemyRows &enemies = w.enemies;
+    BossRows &bosses = w.bosses;
+    // Rows as of now; anything spawned during the tick starts next tick
+    const int count = enemies.size();
+    const int bossCount = bosses.size();
+    const bool survival = w.mode == MODE_SURVIVAL;
+
+    const bool anyEnemyAlive = count + bossCount > 0;
+
+    // Formation movement: zig zag down (survival only turns around), then
+    // the whole block steps sideways. With every enemy out diving it holds
+    // still, so they don't fly back to a spot off the screen.
+    Formation &formation = w.formation;
+    if (formation.size() > 0)
+    {
+        if (formation.minX() < tuning.formMargin && formation.dir < 0)
+        {
+            formation.dir = 1;
+            if (!survival)
+                formation.offset.y += tuning.formDropY;
+        }
+        else if (formation.maxX() > WINDOW_WIDTH - tuning.formMargin && formation.dir > 0)
+        {
+            formation.dir = -1;
+            if (!survival)
+                formation.offset.y += tuning.formDropY;
+        }
+        formation.offset.x += formation.dir * tuning.formSpeed * dt;
+    }
+
+    // Random Enemy attack
+    for (const TimedEvent &e : w.due)
+        if (e.kind == TIMED_DIVE && isCurrent(w, e))
+            startDive(w);
+
+    {
+        const Health *health = bosses.column<Health>();
+        BossBrain *brain = bosses.column<BossBrain>();
+        for (int i = 0; i < bossCount; ++i)
+            brain[i].phase = bossPhase(health[i]);
+    }
+
+    EnemyStep &step = w.enemyStep;
+    EnemyStep &bossStep = w.bossStep;
+    stepEnemies(w, enemies, true, dt, step);
+    stepEnemies(w, bosses, false, dt, bossStep);
+
+    // Crashes, then the shots and flashes due this tick (firing queues
+    // bullets and minions and rolls worldRand), then formation joins/leaves
+    for (std::size_t k = 0; k < step.crashed.size(); ++k)
+    {
+        despawnEnemy(w, enemies, step.crashed[k]);
+        ev.crash = true;
+        damagePlayer(w, playerAt(w, step.victims[k]), 10, ev);
+    }
+    for (const TimedEvent &e : w.due)
+    {
+        if (e.kind != TIMED_FIRE && e.kind != TIMED_FLASH_END)
+            continue;
+        if (e.boss)
+        {
+            int row = bosses.find(e.id);
+            if (row < 0 || bosses.despawning(row))
+                continue;
+            if (e.kind == TIMED_FIRE)
+                bossFires(w, row);
+            else
+                endHitFlash(w, bosses, row, true);
+        }
+        else
+        {
+            int row = enemies.find(e.id);
+            if (row < 0 || enemies.despawning(row))
+                continue;
+            if (e.kind == TIMED_FIRE)
+                enemyFires(w, row);
+            else
+                endHitFlash(w, enemies, row, false);
+        }
+    }
+    auto sync = [&](auto &rows)
+    {
+        const Body *body = rows.template column<Body>();
+        const Dive *dive = rows.template column<Dive>();
+        const BasePos *base = rows.template column<BasePos>();
+        Rank *rank = rows.template column<Rank>();
+        for (int i = 0; i < rows.size(); ++i)
+            if (!rows.despawning(i))
+                syncFormation(formation, dive[i], rank[i], base[i], body[i].radius);
+    };
+    sync(enemies);
+    sync(bosses);
+
+    if (survival)
+    {
+        w.survivalTimer += dt;
+        for (const TimedEvent &e : w.due)
+        {
+            if (!isCurrent(w, e))
+                continue;
+            if (e.kind == TIMED_SPAWN)
+                spawnSurvivalEnemy(w);
+            else if (e.kind == TIMED_BOSS)
+                spawnSurvivalBoss(w);
+        }
+        // Score tính bằng thời gian sống (10 điểm / giây)
+        w.score = (int)w.survivalTimer * 10;
+    }
+    else if (!anyEnemyAlive)
+    {
+        w.level += 1;
+        spawnEnemy(w, w.level);
+    }
+    flushEnemies(w);
+    w.eBullets.flush();
+}
+
+inline void updateEnemyBullets(World &w, float dt, JobSystem &jobs, TickEvents &ev)
+{
+    // Integer sums per player, so the totals don't depend on how the chunks were split
+    std::atomic<int> hits[MAX_PLAYERS] = {}, damage[MAX_PLAYERS] = {};
+    const int players = playerCount(w);
+    BulletRows &bullets = w.eBullets;
+    jobs.parallelFor(bullets.size(), BULLET_GRAIN, [&](int begin, int end)
+                     {
+                         moveBullets(bullets, begin, end, dt);
+                         const Position *pos = bullets.column<Position>();
+                         const Velocity *vel = bullets.column<Velocity>();
+                         const Damage *bulletDamage = bullets.column<Damage>();
+                         int n[MAX_PLAYERS] = {}, dmg[MAX_PLAYERS] = {};
+                         for (int i = begin; i < end; ++i)
+                         {
+                             if (bullets.despawning(i))
+                                 continue;
+                             for (int p = 0; p < players; ++p)
+                             {
+                                 const Player &player = playerAt(w, p);
+                                 // Over the whole move, so a long tick can't carry a bullet through the player
+                                 if (inPlay(w, player) &&
+                                     sweptCircleHit(pos[i] - vel[i] * dt, vel[i] * dt, BULLET_RADIUS, player.pos, player.radius) >= 0.f)
+                                 {
+                                     n[p]++;
+                                     dmg[p] += bulletDamage[i].value;
+                                     bullets.despawn(i);
+                                     break;
+                                 }
+                             }
+                         }
+                         for (int p = 0; p < players; ++p)
+                             if (n[p] > 0)
+                             {
+                                 hits[p].fetch_add(n[p], std::memory_order_relaxed);
+                                 damage[p].fetch_add(dmg[p], std::memory_order_relaxed);
+                             } });
+    bullets.flush();
+
+    for (int p = 0; p < players; ++p)
+        if (hits[p].load() > 0)
+        {
+            ev.hit = true;
+            damagePlayer(w, playerAt(w, p), damage[p].load(), ev);
+        }
+}
+
+inline void updateItems(World &w, float dt, TickEvents &ev)
+{
+    ItemRows &items = w.items;
+    Position *pos = items.column<Position>();
+    const Pickup *pickup = items.column<Pickup>();
+    for (int i = 0; i < items.size(); ++i)
+    {
+        pos[i].y += tuning.itemFallSpeed * dt;
+        if (pos[i].y > WINDOW_HEIGHT + 30.f)
+        {
+            items.despawn(i);
+            continue;
+        }
+        const int taker = touchedPlayer(w, pos[i], ITEM_RADIUS);
+        if (taker >= 0)
+        {
+            Player &player = playerAt(w, taker);
+            const ItemType type = pickup[i].type;
+            ev.pickup |= triggerPickupEffect(w, player.pos, itemColor(type));
+            if (type == ITEM_DMG)
+            {
+                player.damage += 1;
+            }
+            else if (type == ITEM_SINGLE || type == ITEM_DOUBLE || type == ITEM_SPREAD)
+            {
+                ShootingStyle picked = SINGLE;
+                if (type == ITEM_DOUBLE)
+                    picked = DOUBLE;
+                else if (type == ITEM_SPREAD)
+                    picked = SPREAD;
+                // Cộng thêm 1 sát thương nếu đã là kiểu bắn này
+                if (player.style == picked)
+                    player.damage += 1;
+                player.style = picked;
+            }
+            else if (type == HEAL)
+            {
+                player.hp += 20;
+                if (player.hp >= 100)
+                {
+                    player.hp = 100;
+                }
+            }
+            items.despawn(i);
+        }
+    }
+    items.flush();
+    w.pickupEffects.flush();
+}
+
+// Explosion frames and pickup rings
+inline void ageEffects(World &w, float dt, JobSystem &jobs)
+{
+    ExplosionRows &explosions = w.explosions;
+    jobs.parallelFor(explosions.size(), EFFECT_GRAIN, [&](int begin, int end)
+                     {
+                         ExplosionFrame *frame = explosions.column<ExplosionFrame>();
+                         for (int i = begin; i < end; ++i)
+                         {
+                             frame[i].frameTimer += dt;
+                             if (frame[i].frameTimer >= tuning.explosionFrameDuration)
+                             {
+                                 frame[i].frameTimer = 0.f;
+                                 frame[i].currentFrame++;
+                                 if (frame[i].currentFrame >= EXPLOSION_FRAMES)
+                                     explosions.despawn(i); // Animation kết thúc
+                             }
+                         } });
+
+    RingRows &rings = w.pickupEffects;
+    jobs.parallelFor(rings.size(), EFFECT_GRAIN, [&](int begin, int end)
+                     {
+                         Ring *ring = rings.column<Ring>();
+                         for (int i = begin; i < end; ++i)
+                         {
+                             ring[i].radius += tuning.effectExpandSpeed * dt;
+                             ring[i].alpha -= tuning.effectFadeSpeed * dt;
+                             if (ring[i].alpha <= 0)
+                                 rings.despawn(i);
+                         } });
+
+    explosions.flush();
+    rings.flush();
+}
+
+// One input per ship; the second is ignored outside co-op
+inline void updateWorld(World &w, const TickInput (&in)[MAX_PLAYERS], float dt, JobSystem &jobs, TickEvents &ev)
+{
+    if (w.armedMode != (int)w.mode)
+        armTimers(w);
+    w.due.clear();
+    w.timers.advance(w.due);
+    for (int i = 0; i < playerCount(w); ++i)
+        updatePlayer(w, playerAt(w, i), in[i], dt, ev);
+    updatePlayerBullets(w, dt, jobs, ev);
+    updateEnemies(w, dt, ev);
+    updateEnemyBullets(w, dt, jobs, ev);
+    updateItems(w, dt, ev);
+    // Stress runs are for measuring, so the player can't die
+    if (w.mode == MODE_STRESS)
+        for (int i = 0; i < playerCount(w); ++i)
+            playerAt(w, i).hp = 100;
+    ageEffects(w, dt, jobs);
+}
+
+inline void updateWorld(World &w, const TickInput &in, float dt, JobSystem &jobs, TickEvents &ev)
+{
+    const TickInput both[MAX_PLAYERS] = {in, TickInput()};
+    updateWorld(w, both, dt, jobs, ev);
+}
+
+// Order-sensitive hash of the state a tick changes. Equal worlds give equal
+// sums, so two machines running the same game can compare them.
+inline unsigned long long worldChecksum(const World &w)
+{
+    unsigned long long h = 1469598103934665603ULL;
+    auto mix = [&](float v)
+    {
+        unsigned bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        h = (h ^ bits) * 1099511628211ULL;
+    };
+    auto mixEnemies = [&](const auto &rows)
+    {
+        const Position *pos = rows.template column<Position>();
+        const Health *health = rows.template column<Health>();
+        for (int i = 0; i < rows.size(); ++i)
+        {
+            mix((float)rows.id(i).index);
+            mix(pos[i].x);
+            mix(pos[i].y);
+            mix((float)health[i].hp);
+        }
+    };
+    mixEnemies(w.enemies);
+    mixEnemies(w.bosses);
+    const Position *ePos = w.eBullets.column<Position>();
+    for (int i = 0; i < w.eBullets.size(); ++i)
+    {
+        mix((float)w.eBullets.id(i).index);
+        mix(ePos[i].x);
+        mix(ePos[i].y);
+    }
+    const Position *pPos = w.pBullets.column<Position>();
+    for (int i = 0; i < w.pBullets.size(); ++i)
+        mix(pPos[i].y);
+    const Pickup *pickup = w.items.column<Pickup>();
+    for (int i = 0; i < w.items.size(); ++i)
+        mix((float)pickup[i].type);
+    mix((float)w.score);
+    mix((float)w.level);
+    for (int i = 0; i < playerCount(w); ++i)
+    {
+        mix((float)playerAt(w, i).hp);
+        mix(playerAt(w, i).pos.x);
+        mix((float)playerAt(w, i).style);
+    }
+    return h;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <SFML/Window/Event.hpp>
+#include "Game.hpp"
+
+enum InputAction : unsigned char
+{
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    ACTION_FIRE,
+    ACTION_COUNT
+};
+
+// How often the game loop drains window events while a game is on,
+// which is how precise the event timestamps are
+const float INPUT_POLL_SECONDS = 0.002f;
+
+// A key going down or up, stamped when pollEvent handed it over.
+// Plain data, so a stream of these can be saved and replayed.
+struct InputEvent
+{
+    double time; // seconds on InputQueue::now()
+    InputAction action;
+    bool down;
+};
+
+// Turns key events into per-tick input. Transitions are queued with their
+// arrival time and each tick takes the ones inside its own time window, so
+// a tap between two ticks still fires and movement counts exactly how long
+// the key was held, whatever the frame rate.
+class InputQueue
+{
+public:
+    // Seconds since the queue was made; tick windows use the same clock
+    double now() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Feed every polled event through here
+    void onEvent(const sf::Event &event)
+    {
+        if (event.type == sf::Event::LostFocus)
+        {
+            // No KeyReleased arrives while the window is in the background
+            for (int k = 0; k < KEY_SLOTS; ++k)
+                if (keyDown[k])
+                    setKey(k, false);
+            return;
+        }
+        if (event.type != sf::Event::KeyPressed && event.type != sf::Event::KeyReleased)
+            return;
+        int k = keySlot(event.key.code);
+        if (k >= 0)
+            setKey(k, event.type == sf::Event::KeyPressed);
+    }
+
+    // Input for the tick covering [tickStart, tickEnd). Events from before
+    // tickStart (after a stall, or ones left from the previous tick) count
+    // as happening at its start.
+    TickInput consume(double tickStart, double tickEnd)
+    {
+        TickInput in;
+        float held[ACTION_COUNT] = {};
+        double t = tickStart;
+        auto advance = [&](double until)
+        {
+            if (until <= t)
+                return;
+            for (int a = 0; a < ACTION_COUNT; ++a)
+                if (actionDown[a])
+                    held[a] += (float)(until - t);
+            t = until;
+        };
+
+        while (head < queue.size() && queue[head].time < tickEnd)
+        {
+            const InputEvent &ev = queue[head++];
+            advance(ev.time);
+            actionDown[ev.action] = ev.down;
+            if (ev.action == ACTION_FIRE && ev.down)
+                in.firePressed = true;
+            if (recording)
+                recording->push_back(ev);
+        }
+        advance(tickEnd);
+        compact();
+
+        float span = (float)(tickEnd - tickStart);
+        if (span > 0.f)
+            in.moveDir = (held[ACTION_RIGHT] - held[ACTION_LEFT]) / span;
+        in.fire = actionDown[ACTION_FIRE];
+        return in;
+    }
+
+    // Apply everything queued up to `time` without making ticks of it
+    // (menus, pause)
+    void skipTo(double time)
+    {
+        while (head < queue.size() && queue[head].time < time)
+        {
+            actionDown[queue[head].action] = queue[head].down;
+            head++;
+        }
+        compact();
+    }
+
+    // Consumed events are appended here when set
+    std::vector<InputEvent> *recording = nullptr;
+
+private:
+    static const int KEY_SLOTS = 5;
+
+    // Left/A, Right/D, Space
+    static int keySlot(sf::Keyboard::Key code)
+    {
+        switch (code)
+        {
+        case sf::Keyboard::Left:
+            return 0;
+        case sf::Keyboard::A:
+            return 1;
+        case sf::Keyboard::Right:
+            return 2;
+        case sf::Keyboard::D:
+            return 3;
+        case sf::Keyboard::Space:
+            return 4;
+        default:
+            return -1;
+        }
+    }
+
+    static InputAction slotAction(int k)
+    {
+        if (k < 2)
+            return ACTION_LEFT;
+        if (k < 4)
+            return ACTION_RIGHT;
+        return ACTION_FIRE;
+    }
+
+    // Key repeat sends more KeyPressed for a held key; only real transitions
+    // of the action (either of its keys) are queued
+    void setKey(int k, bool down)
+    {
+        if (keyDown[k] == down)
+            return;
+        InputAction action = slotAction(k);
+        bool wasDown = anyKeyDown(action);
+        keyDown[k] = down;
+        if (anyKeyDown(action) != wasDown)
+            queue.push_back({now(), action, down});
+    }
+
+    bool anyKeyDown(InputAction action) const
+    {
+        for (int k = 0; k < KEY_SLOTS; ++k)
+            if (keyDown[k] && slotAction(k) == action)
+                return true;
+        return false;
+    }
+
+    // Drop consumed events; neither branch gives memory back, so a warm
+    // queue doesn't allocate
+    void compact()
+    {
+        if (head == queue.size())
+        {
+            queue.clear();
+            head = 0;
+        }
+        else if (head >= 64)
+        {
+            queue.erase(queue.begin(), queue.begin() + head);
+            head = 0;
+        }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<InputEvent> queue;
+    std::size_t head = 0;
+    bool keyDown[KEY_SLOTS] = {};
+    // Action state as of the last consumed event
+    bool actionDown[ACTION_COUNT] = {};
+};
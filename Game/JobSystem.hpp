@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "AllocGuard.hpp"
+
+// Small work-stealing thread pool for splitting a game tick into chunks.
+// Every thread owns a queue: it takes work from the back of its own queue and,
+// when that is empty, steals from the front of the others'. parallelFor()
+// blocks until all its chunks are done and the calling thread works on them
+// too, so with 0 workers everything simply runs inline.
+// parallelFor() must only be called from one thread (the game loop).
+class JobSystem
+{
+public:
+    explicit JobSystem(unsigned workers = defaultWorkers())
+    {
+        // Queue 0 belongs to the calling thread
+        for (unsigned i = 0; i <= workers; ++i)
+            queues.push_back(std::make_unique<Queue>());
+        for (unsigned i = 1; i <= workers; ++i)
+            threads.emplace_back([this, i] { workerLoop((int)i); });
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto &t : threads)
+            t.join();
+    }
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // One thread per core, counting the caller
+    static unsigned defaultWorkers()
+    {
+        unsigned n = std::thread::hardware_concurrency();
+        return n > 1 ? n - 1 : 0;
+    }
+
+    // Threads working on parallelFor(), including the caller
+    int threadCount() const { return (int)queues.size(); }
+
+    // Calls fn(begin, end) over [0, count) in chunks of at least `grain` items.
+    // Chunks run in any order and on any thread, so fn may only write inside
+    // its own range; ordered side effects belong in a serial pass afterwards.
+    template <typename Fn>
+    void parallelFor(int count, int grain, Fn &&fn)
+    {
+        if (count <= 0)
+            return;
+        int nThreads = threadCount();
+        if (nThreads == 1 || count <= grain)
+        {
+            fn(0, count);
+            return;
+        }
+
+        int chunks = std::min((count + grain - 1) / grain, nThreads * CHUNKS_PER_THREAD);
+        int size = (count + chunks - 1) / chunks;
+
+        using F = std::remove_reference_t<Fn>;
+        std::atomic<int> pending{0};
+        Job job;
+        job.fn = [](void *ctx, int begin, int end)
+        { (*static_cast<F *>(ctx))(begin, end); };
+        job.ctx = const_cast<void *>(static_cast<const void *>(&fn));
+        job.pending = &pending;
+        job.guarded = allocGuardDepth > 0;
+
+        // Deal the chunks out round-robin so every thread starts with some
+        for (int c = 0, begin = 0; begin < count; ++c, begin += size)
+        {
+            job.begin = begin;
+            job.end = std::min(count, begin + size);
+            pending.fetch_add(1, std::memory_order_relaxed);
+            if (!push(c % nThreads, job))
+                run(job);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+
+        // Help out until every chunk of this call is finished
+        while (pending.load(std::memory_order_acquire) > 0)
+        {
+            Job j;
+            if (pop(0, j) || steal(0, j))
+                run(j);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    static const int CHUNKS_PER_THREAD = 4;
+    static const unsigned QUEUE_SIZE = 64;
+
+    struct Job
+    {
+        void (*fn)(void *, int, int) = nullptr;
+        void *ctx = nullptr;
+        int begin = 0, end = 0;
+        std::atomic<int> *pending = nullptr;
+        bool guarded = false; // queued from inside an AllocGuard
+    };
+
+    // Fixed ring, so queuing never allocates; [head, tail) are waiting jobs
+    struct alignas(64) Queue
+    {
+        std::mutex m;
+        Job jobs[QUEUE_SIZE];
+        unsigned head = 0, tail = 0;
+    };
+
+    bool push(int q, const Job &job)
+    {
+        Queue &queue = *queues[q];
+        std::lock_guard<std::mutex> lock(queue.m);
+        if (queue.tail - queue.head == QUEUE_SIZE)
+            return false;
+        queue.jobs[queue.tail++ % QUEUE_SIZE] = job;
+        queued.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner end: newest first, still warm in cache
+    bool pop(int q, Job &out)
+    {
+        Queue &queue = *queues[q];
+        std::lock_guard<std::mutex> lock(queue.m);
+        if (queue.head == queue.tail)
+            return false;
+        out = queue.jobs[--queue.tail % QUEUE_SIZE];
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Thief end: oldest first, starting with the next queue over
+    bool steal(int self, Job &out)
+    {
+        int n = threadCount();
+        for (int k = 1; k < n; ++k)
+        {
+            Queue &queue = *queues[(self + k) % n];
+            std::lock_guard<std::mutex> lock(queue.m);
+            if (queue.head == queue.tail)
+                continue;
+            out = queue.jobs[queue.head++ % QUEUE_SIZE];
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    static void run(const Job &job)
+    {
+        AllocGuard guard(job.guarded && allocGuardDepth == 0);
+        job.fn(job.ctx, job.begin, job.end);
+        job.pending->fetch_sub(1, std::memory_order_release);
+    }
+
+    void workerLoop(int self)
+    {
+        for (;;)
+        {
+            Job j;
+            if (pop(self, j) || steal(self, j))
+            {
+                run(j);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this]
+                      { return quit || queued.load(std::memory_order_acquire) > 0; });
+            if (quit)
+                return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> queued{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool quit = false;
+};
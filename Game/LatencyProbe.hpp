@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <SFML/Window/Event.hpp>
+
+// Measures shot lag. A press of the fire key is followed from the moment
+// pollEvent hands it over, through the tick whose input shows it, to the
+// return of window.display() for the first frame drawn from that tick.
+// One press is tracked at a time; a press followed by another before any
+// tick acted on it is counted as a lost tap.
+//
+// onEvent/onSample run on the main thread, onDisplay on whichever thread
+// presents frames.
+class LatencyProbe
+{
+public:
+    explicit LatencyProbe(bool enabled) : enabled(enabled)
+    {
+        eventToDisplay.reserve(REPORT_EVERY);
+        sampleToDisplay.reserve(REPORT_EVERY);
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    void onEvent(const sf::Event &event)
+    {
+        if (!enabled)
+            return;
+        if (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Space)
+            spaceDown = false;
+        if (event.type != sf::Event::KeyPressed || event.key.code != sf::Keyboard::Space || spaceDown)
+            return; // key repeat
+        spaceDown = true;
+
+        int expected = IDLE;
+        if (stage.compare_exchange_strong(expected, EVENT_SEEN, std::memory_order_acq_rel))
+            eventNs = nowNs();
+        else if (expected == EVENT_SEEN)
+        {
+            // The last press never made it into a tick; follow this one instead
+            lostTaps.fetch_add(1, std::memory_order_relaxed);
+            eventNs = nowNs();
+        }
+    }
+
+    // `tick` is the number the tick about to run will publish its snapshot with
+    void onSample(bool fired, unsigned long long tick)
+    {
+        if (!enabled)
+            return;
+        if (fired && stage.load(std::memory_order_acquire) == EVENT_SEEN)
+        {
+            sampleNs = nowNs();
+            sampledTick = tick;
+            stage.store(SAMPLED, std::memory_order_release);
+        }
+    }
+
+    // Call right after window.display(), with the newest tick in the frame
+    void onDisplay(unsigned long long shownTick)
+    {
+        if (!enabled || stage.load(std::memory_order_acquire) != SAMPLED || shownTick < sampledTick)
+            return;
+        long long now = nowNs();
+        eventToDisplay.push_back((now - eventNs) / 1e6f);
+        sampleToDisplay.push_back((now - sampleNs) / 1e6f);
+        stage.store(IDLE, std::memory_order_release);
+
+        if ((int)eventToDisplay.size() >= REPORT_EVERY)
+            report();
+    }
+
+private:
+    static const int REPORT_EVERY = 20;
+    enum Stage
+    {
+        IDLE,
+        EVENT_SEEN,
+        SAMPLED
+    };
+
+    static long long nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static void printStats(const char *name, std::vector<float> &ms)
+    {
+        std::sort(ms.begin(), ms.end());
+        float sum = 0.f;
+        for (float v : ms)
+            sum += v;
+        std::printf(" | %s avg %.1f p50 %.1f p95 %.1f max %.1f ms", name, sum / ms.size(),
+                    ms[ms.size() / 2], ms[ms.size() * 95 / 100], ms.back());
+    }
+
+    void report()
+    {
+        std::printf("[latency] %d shots", (int)eventToDisplay.size());
+        printStats("event->display", eventToDisplay);
+        printStats("sample->display", sampleToDisplay);
+        std::printf(" | lost taps %d\n", lostTaps.exchange(0));
+        std::fflush(stdout);
+        eventToDisplay.clear();
+        sampleToDisplay.clear();
+    }
+
+    const bool enabled;
+    bool spaceDown = false;
+    std::atomic<int> stage{IDLE};
+    // Written by the main thread before `stage` is released to SAMPLED
+    long long eventNs = 0;
+    long long sampleNs = 0;
+    unsigned long long sampledTick = 0;
+    std::atomic<int> lostTaps{0};
+
+    // Only touched in onDisplay
+    std::vector<float> eventToDisplay;
+    std::vector<float> sampleToDisplay;
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <vector>
+
+struct Button
+{
+    sf::RectangleShape rect;
+    sf::Text text;
+    bool isHovered(const sf::Vector2f &mousePos) const
+    {
+        return rect.getGlobalBounds().contains(mousePos);
+    }
+    float t = 0;
+    bool hovered = false; // look it was last styled with
+};
+
+// Normal or hover look: hover is lighter, yellow and 10% bigger
+inline void styleButton(Button &btn, bool hovered)
+{
+    btn.hovered = hovered;
+    if (hovered)
+    {
+        btn.rect.setFillColor(sf::Color(80, 80, 80));
+        btn.rect.setOutlineColor(sf::Color::Yellow);
+        btn.text.setFillColor(sf::Color(255, 255, 0)); // Vàng
+        btn.rect.setScale(1.1f, 1.1f);
+        btn.text.setScale(1.1f, 1.1f);
+    }
+    else
+    {
+        btn.rect.setFillColor(sf::Color(50, 50, 50));
+        btn.rect.setOutlineColor(sf::Color::White);
+        btn.text.setFillColor(sf::Color::White);
+        btn.rect.setScale(1.0f, 1.0f);
+        btn.text.setScale(1.0f, 1.0f);
+    }
+}
+
+// A menu screen kept in a render texture. The static part (background,
+// titles, text) is drawn once per visit into canvas(), the buttons are baked
+// over it, and afterwards a button is re-rendered only when its hover state
+// flips. A menu frame then costs one blit plus whatever the screen animates.
+class MenuLayer
+{
+public:
+    bool create(unsigned width, unsigned height)
+    {
+        return base.create(width, height) && layer.create(width, height);
+    }
+
+    // Redraw everything on the next begin()
+    void invalidate() { screen = -1; }
+
+    // Start a frame of screen `key` with these buttons. True on the first
+    // frame of a visit: draw the static part into canvas() before present().
+    bool begin(int key, std::initializer_list<Button *> list)
+    {
+        buttons.assign(list);
+        if (key == screen)
+            return false;
+        screen = key;
+        stale = true;
+        base.clear();
+        return true;
+    }
+
+    sf::RenderTarget &canvas() { return base; }
+
+    // Restyle the buttons for `mouse`, re-render those that changed and draw
+    // the layer onto `target`. With `liftHovered` a hovered button is left
+    // out of the cache and drawn live on top, so the screen can animate it.
+    void present(sf::RenderTarget &target, const sf::Vector2f &mouse, bool liftHovered = false)
+    {
+        if (stale)
+        {
+            base.display();
+            layer.draw(sf::Sprite(base.getTexture()), replace());
+        }
+        for (Button *b : buttons)
+        {
+            const bool hover = b->isHovered(mouse);
+            if (!stale && hover == b->hovered)
+                continue;
+            const sf::FloatRect before = b->rect.getGlobalBounds();
+            styleButton(*b, hover);
+            if (!stale)
+            {
+                restore(before);
+                restore(b->rect.getGlobalBounds());
+            }
+            if (!(hover && liftHovered))
+            {
+                layer.draw(b->rect);
+                layer.draw(b->text);
+            }
+        }
+        stale = false;
+        layer.display();
+        target.draw(sf::Sprite(layer.getTexture()));
+        if (liftHovered)
+            for (Button *b : buttons)
+                if (b->hovered)
+                {
+                    target.draw(b->rect);
+                    target.draw(b->text);
+                }
+    }
+
+private:
+    static sf::RenderStates replace()
+    {
+        sf::RenderStates states;
+        states.blendMode = sf::BlendNone;
+        return states;
+    }
+
+    // Copy the static part back over `area`, wiping whatever was baked there
+    void restore(const sf::FloatRect &area)
+    {
+        const sf::Vector2u size = base.getTexture().getSize();
+        const int left = std::max(0, (int)std::floor(area.left) - 2);
+        const int top = std::max(0, (int)std::floor(area.top) - 2);
+        const int right = std::min((int)size.x, (int)std::ceil(area.left + area.width) + 2);
+        const int bottom = std::min((int)size.y, (int)std::ceil(area.top + area.height) + 2);
+        if (right <= left || bottom <= top)
+            return;
+        sf::Sprite patch(base.getTexture(), sf::IntRect(left, top, right - left, bottom - top));
+        patch.setPosition((float)left, (float)top);
+        layer.draw(patch, replace());
+    }
+
+    sf::RenderTexture base;  // static part only
+    sf::RenderTexture layer; // static part plus buttons, what gets blitted
+    std::vector<Button *> buttons;
+    int screen = -1;
+    bool stale = true;
+};
+
+// The pause backdrop: `shot` shrunk by `factor` (each pixel the average of a
+// factor x factor block), box-blurred once more and multiplied by `shade`.
+// Drawn scaled back up with smoothing on, it reads as a soft blur of the
+// frozen game, at a fraction of the cost of drawing the game again.
+inline sf::Image blurredBackdrop(const sf::Image &shot, unsigned factor, float shade)
+{
+    const sf::Vector2u size = shot.getSize();
+    const unsigned w = std::max(1u, size.x / factor), h = std::max(1u, size.y / factor);
+    const sf::Uint8 *src = shot.getPixelsPtr();
+    std::vector<float> small(w * h * 3, 0.f);
+    for (unsigned y = 0; y < h; ++y)
+        for (unsigned x = 0; x < w; ++x)
+        {
+            float sum[3] = {0.f, 0.f, 0.f};
+            unsigned n = 0;
+            for (unsigned sy = y * factor; sy < std::min(size.y, (y + 1) * factor); ++sy)
+                for (unsigned sx = x * factor; sx < std::min(size.x, (x + 1) * factor); ++sx, ++n)
+                    for (int c = 0; c < 3; ++c)
+                        sum[c] += src[(sy * size.x + sx) * 4 + c];
+            for (int c = 0; c < 3; ++c)
+                small[(y * w + x) * 3 + c] = n ? sum[c] / n : 0.f;
+        }
+
+    // 3x3 box blur, edges clamped
+    std::vector<sf::Uint8> out(w * h * 4);
+    for (unsigned y = 0; y < h; ++y)
+        for (unsigned x = 0; x < w; ++x)
+        {
+            float sum[3] = {0.f, 0.f, 0.f};
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    const unsigned sx = (unsigned)std::min(std::max((int)x + dx, 0), (int)w - 1);
+                    const unsigned sy = (unsigned)std::min(std::max((int)y + dy, 0), (int)h - 1);
+                    for (int c = 0; c < 3; ++c)
+                        sum[c] += small[(sy * w + sx) * 3 + c];
+                }
+            for (int c = 0; c < 3; ++c)
+                out[(y * w + x) * 4 + c] = (sf::Uint8)(sum[c] / 9.f * shade);
+            out[(y * w + x) * 4 + 3] = 255;
+        }
+    sf::Image backdrop;
+    backdrop.create(w, h, out.data());
+    return backdrop;
+}
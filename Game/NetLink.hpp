@@ -0,0 +1,130 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <random>
+
+// Made-up bad network for testing on one machine: every datagram sent is
+// held back `delayMs` plus up to `jitterMs` and dropped with `lossPercent`
+// chance, so two copies of the game on 127.0.0.1 play as if far apart.
+struct NetConditions
+{
+    int delayMs = 0;
+    int jitterMs = 0;
+    float lossPercent = 0.f;
+};
+
+// One UDP socket talking to one peer. Non-blocking throughout: send() never
+// waits and receive() returns false when nothing has arrived.
+class NetLink
+{
+public:
+    static const std::size_t MAX_DATAGRAM = 512;
+
+    // Wait on `port` for whoever sends first; they become the peer
+    bool listen(unsigned short port)
+    {
+        peer = sf::IpAddress::None;
+        return open(port);
+    }
+
+    // Talk to `address:port`, from any free local port
+    bool connect(const sf::IpAddress &address, unsigned short port)
+    {
+        peer = address;
+        peerPort = port;
+        return open(sf::Socket::AnyPort);
+    }
+
+    void setConditions(const NetConditions &c) { conditions = c; }
+
+    bool hasPeer() const { return peer != sf::IpAddress::None; }
+    unsigned short localPort() const { return socket.getLocalPort(); }
+
+    void send(const unsigned char *data, std::size_t size)
+    {
+        if (!hasPeer() || size > MAX_DATAGRAM)
+            return;
+        if (conditions.lossPercent > 0.f && std::uniform_real_distribution<float>(0.f, 100.f)(rng) < conditions.lossPercent)
+            return;
+        if (conditions.delayMs <= 0 && conditions.jitterMs <= 0)
+        {
+            socket.send(data, size, peer, peerPort);
+            return;
+        }
+        Delayed d;
+        int ms = conditions.delayMs;
+        if (conditions.jitterMs > 0)
+            ms += std::uniform_int_distribution<int>(0, conditions.jitterMs)(rng);
+        d.due = Clock::now() + std::chrono::milliseconds(ms);
+        std::memcpy(d.data, data, size);
+        d.size = size;
+        // Jitter may reorder datagrams, as a real network does
+        auto at = delayed.end();
+        while (at != delayed.begin() && std::prev(at)->due > d.due)
+            --at;
+        delayed.insert(at, d);
+    }
+
+    // Hand over the delayed datagrams that are due, then the next one that
+    // arrived from the peer, if any. `size` gets its length.
+    bool receive(unsigned char *data, std::size_t &size)
+    {
+        const Clock::time_point now = Clock::now();
+        while (!delayed.empty() && delayed.front().due <= now)
+        {
+            socket.send(delayed.front().data, delayed.front().size, peer, peerPort);
+            delayed.pop_front();
+        }
+
+        sf::IpAddress from;
+        unsigned short fromPort = 0;
+        for (;;)
+        {
+            if (socket.receive(data, MAX_DATAGRAM, size, from, fromPort) != sf::Socket::Done)
+                return false;
+            if (!hasPeer())
+            {
+                peer = from;
+                peerPort = fromPort;
+            }
+            // Anyone else is ignored
+            if (from == peer && fromPort == peerPort)
+                return true;
+        }
+    }
+
+    void close()
+    {
+        socket.unbind();
+        delayed.clear();
+        peer = sf::IpAddress::None;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Delayed
+    {
+        Clock::time_point due;
+        unsigned char data[MAX_DATAGRAM];
+        std::size_t size = 0;
+    };
+
+    bool open(unsigned short port)
+    {
+        socket.unbind();
+        socket.setBlocking(false);
+        return socket.bind(port) == sf::Socket::Done;
+    }
+
+    sf::UdpSocket socket;
+    sf::IpAddress peer = sf::IpAddress::None;
+    unsigned short peerPort = 0;
+    NetConditions conditions;
+    std::deque<Delayed> delayed; // by due time
+    std::minstd_rand rng{std::random_device{}()};
+};
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "Game.hpp"
+
+// Everything the render thread needs to draw one PLAYING frame, copied out
+// of the World after a tick. Only live entities are stored; `slot` comes
+// from the entity's id, so a frame can be matched up with the one before it.
+
+enum SpriteId : unsigned char
+{
+    SPRITE_ENEMY,
+    SPRITE_BOSS
+};
+
+struct EnemyDraw
+{
+    int slot;            // id index * 2, plus 1 for bosses
+    unsigned generation; // changes when the id is reused
+    sf::Vector2f pos;
+    float t; // drives the bobbing
+    float hpPercent;
+    SpriteId sprite;
+};
+
+// Bullets and items are drawn as cached text labels. The label id of a bullet
+// is its damage, the label id of an item its ItemType.
+struct LabelDraw
+{
+    int slot;
+    unsigned generation; // as EnemyDraw's
+    sf::Vector2f pos;
+    int label;
+};
+
+struct ExplosionDraw
+{
+    sf::Vector2f pos;
+    int frame;
+};
+
+struct RingDraw
+{
+    sf::Vector2f pos;
+    float radius;
+    sf::Color color; // alpha already applied
+};
+
+struct HudValues
+{
+    int hp = 100;
+    int damage = 0;
+    int level = 1;
+    int score = 0;
+    int survivalSeconds = 0;
+    GameMode mode = MODE_NORMAL;
+    bool coop = false;
+    int hp2 = 0; // co-op: the second ship's
+    int damage2 = 0;
+    ShootingStyle style = SINGLE;
+    ShootingStyle style2 = SINGLE;
+    float rewindSeconds = -1.f; // how far back a rewound frame is; -1 when live
+};
+
+struct RenderSnapshot
+{
+    unsigned long long tick = 0;
+    std::chrono::steady_clock::time_point publishedAt;
+    sf::Vector2f playerPos;
+    sf::Vector2f player2Pos; // co-op only
+    std::vector<EnemyDraw> enemies;
+    std::vector<LabelDraw> pBullets;
+    std::vector<LabelDraw> eBullets;
+    std::vector<LabelDraw> items;
+    std::vector<ExplosionDraw> explosions;
+    std::vector<RingDraw> rings;
+    HudValues hud;
+};
+
+inline void captureLabels(const BulletRows &bullets, std::vector<LabelDraw> &out)
+{
+    out.clear();
+    const Position *pos = bullets.column<Position>();
+    const Damage *damage = bullets.column<Damage>();
+    for (int i = 0; i < bullets.size(); ++i)
+    {
+        SlotHandle id = bullets.id(i);
+        out.push_back({id.index, id.generation, pos[i], damage[i].value});
+    }
+}
+
+template <typename Rows>
+inline void captureEnemies(const Rows &rows, bool boss, std::vector<EnemyDraw> &out)
+{
+    const Position *pos = rows.template column<Position>();
+    const Bob *bob = rows.template column<Bob>();
+    const Health *health = rows.template column<Health>();
+    for (int i = 0; i < rows.size(); ++i)
+    {
+        SlotHandle id = rows.id(i);
+        out.push_back({id.index * 2 + (boss ? 1 : 0), id.generation, pos[i], bob[i].t,
+                       (float)health[i].hp / (float)health[i].maxHp, boss ? SPRITE_BOSS : SPRITE_ENEMY});
+    }
+}
+
+// The vectors keep their capacity, so once every pool has been full at
+// least once this no longer allocates.
+inline void captureSnapshot(const World &w, unsigned long long tick, RenderSnapshot &s)
+{
+    s.tick = tick;
+    s.playerPos = w.player.pos;
+    s.player2Pos = w.player2.pos;
+
+    s.enemies.clear();
+    captureEnemies(w.enemies, false, s.enemies);
+    captureEnemies(w.bosses, true, s.enemies);
+
+    captureLabels(w.pBullets, s.pBullets);
+    captureLabels(w.eBullets, s.eBullets);
+
+    s.items.clear();
+    const Position *itemPos = w.items.column<Position>();
+    const Pickup *pickup = w.items.column<Pickup>();
+    for (int i = 0; i < w.items.size(); ++i)
+    {
+        SlotHandle id = w.items.id(i);
+        s.items.push_back({id.index, id.generation, itemPos[i], (int)pickup[i].type});
+    }
+
+    s.explosions.clear();
+    const Position *explosionPos = w.explosions.column<Position>();
+    const ExplosionFrame *frame = w.explosions.column<ExplosionFrame>();
+    for (int i = 0; i < w.explosions.size(); ++i)
+        s.explosions.push_back({explosionPos[i], frame[i].currentFrame});
+
+    s.rings.clear();
+    const Position *ringPos = w.pickupEffects.column<Position>();
+    const Ring *ring = w.pickupEffects.column<Ring>();
+    for (int i = 0; i < w.pickupEffects.size(); ++i)
+    {
+        sf::Color color = ring[i].color;
+        color.a = static_cast<sf::Uint8>(ring[i].alpha);
+        s.rings.push_back({ringPos[i], ring[i].radius, color});
+    }
+
+    s.hud.hp = w.player.hp;
+    s.hud.damage = w.player.damage;
+    s.hud.level = w.level;
+    s.hud.score = w.score;
+    s.hud.survivalSeconds = (int)w.survivalTimer;
+    s.hud.mode = w.mode;
+    s.hud.coop = w.coop;
+    s.hud.hp2 = w.player2.hp;
+    s.hud.damage2 = w.player2.damage;
+    s.hud.style = w.player.style;
+    s.hud.style2 = w.player2.style;
+    s.hud.rewindSeconds = -1.f;
+}
+
+// Anything that moved further than this between two snapshots was
+// respawned or its slot reused, so it is drawn where it is now
+const float TELEPORT_DIST = 120.f;
+
+inline sf::Vector2f lerp(const sf::Vector2f &a, const sf::Vector2f &b, float alpha)
+{
+    return a + (b - a) * alpha;
+}
+
+// out = cur, with every entity that also was in `prev` (same slot) moved back
+// toward its old position by blend(). Despawns move rows around, so the
+// lists are not in slot order; prev is looked up through a slot table.
+template <typename T, typename Blend>
+inline void blendBySlot(const std::vector<T> &prev, const std::vector<T> &cur, std::vector<T> &out, Blend blend)
+{
+    // Render thread only; all -1 between calls
+    static thread_local std::vector<int> where;
+    for (std::size_t j = 0; j < prev.size(); ++j)
+    {
+        if (prev[j].slot >= (int)where.size())
+            where.resize(prev[j].slot + 1, -1);
+        where[prev[j].slot] = (int)j;
+    }
+
+    out.clear();
+    for (const T &c : cur)
+    {
+        T o = c;
+        int j = c.slot < (int)where.size() ? where[c.slot] : -1;
+        if (j >= 0 && dist2(prev[j].pos, c.pos) < TELEPORT_DIST * TELEPORT_DIST)
+            blend(prev[j], o);
+        out.push_back(o);
+    }
+
+    for (const T &p : prev)
+        where[p.slot] = -1;
+}
+
+// What the world looked like `alpha` of the way from prev to cur. Lets the
+// renderer run at any refresh rate while the simulation stays at TICK_SECONDS.
+// Effects and the HUD are taken from cur as they are.
+inline void interpolateSnapshot(const RenderSnapshot &prev, const RenderSnapshot &cur, float alpha, RenderSnapshot &out)
+{
+    out.tick = cur.tick;
+    out.publishedAt = cur.publishedAt;
+    out.playerPos = cur.playerPos;
+    if (dist2(prev.playerPos, cur.playerPos) < TELEPORT_DIST * TELEPORT_DIST)
+        out.playerPos = lerp(prev.playerPos, cur.playerPos, alpha);
+    out.player2Pos = cur.player2Pos;
+    if (dist2(prev.player2Pos, cur.player2Pos) < TELEPORT_DIST * TELEPORT_DIST)
+        out.player2Pos = lerp(prev.player2Pos, cur.player2Pos, alpha);
+
+    blendBySlot(prev.enemies, cur.enemies, out.enemies, [alpha](const EnemyDraw &p, EnemyDraw &o)
+                {
+                    if (p.generation != o.generation)
+                        return; // a new enemy in the same slot
+                    o.pos = lerp(p.pos, o.pos, alpha);
+                    o.t = p.t + (o.t - p.t) * alpha; });
+    auto blendLabel = [alpha](const LabelDraw &p, LabelDraw &o)
+    {
+        if (p.generation != o.generation)
+            return; // a new bullet or item in the same slot
+        o.pos = lerp(p.pos, o.pos, alpha);
+    };
+    blendBySlot(prev.pBullets, cur.pBullets, out.pBullets, blendLabel);
+    blendBySlot(prev.eBullets, cur.eBullets, out.eBullets, blendLabel);
+    blendBySlot(prev.items, cur.items, out.items, blendLabel);
+
+    out.explosions = cur.explosions;
+    out.rings = cur.rings;
+    out.hud = cur.hud;
+}
+
+// How far the renderer is from `prev` to `cur` at `now`. Drawing runs one
+// tick behind the simulation so there is always a newer state to move toward.
+inline float interpolationAlpha(const RenderSnapshot &prev, const RenderSnapshot &cur,
+                                std::chrono::steady_clock::time_point now)
+{
+    if (cur.tick <= prev.tick)
+        return 1.f;
+    float span = (cur.tick - prev.tick) * TICK_SECONDS;
+    float elapsed = std::chrono::duration<float>(now - cur.publishedAt).count();
+    return std::max(0.f, std::min(1.f, elapsed / span));
+}
+
+// Lock-free triple buffer between the simulation and the render thread.
+// The simulation fills one snapshot while the renderer draws another; the
+// third holds the newest finished one. Neither side ever waits.
+class SnapshotBuffer
+{
+public:
+    // Only the simulation thread touches this one
+    RenderSnapshot &writeSlot() { return slots[writing]; }
+
+    // Hand the filled write slot over and take the spare back
+    void publish()
+    {
+        slots[writing].publishedAt = std::chrono::steady_clock::now();
+        writing = latest.exchange(writing | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Render thread: the newest published snapshot, or the previous one
+    // again if nothing new has been published since
+    const RenderSnapshot &read()
+    {
+        if (latest.load(std::memory_order_relaxed) & FRESH)
+            reading = latest.exchange(reading, std::memory_order_acq_rel) & INDEX;
+        return slots[reading];
+    }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    RenderSnapshot slots[3];
+    std::atomic<int> latest{1};
+    int writing = 0;
+    int reading = 2;
+};
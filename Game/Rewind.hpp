@@ -0,0 +1,527 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <vector>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+#include "Game.hpp"
+
+// The last seconds of play, kept in memory: F9 in a game scrubs back through
+// them (a boss fight, say), and a crash dumps them to REWIND_DUMP_FILE, which
+// --rewind-view=<file> opens for scrubbing again.
+//
+// After every tick the world is flattened into an image: a RewindHeader,
+// then the rows of each archetype. Every KEYFRAME_TICKS-th image is kept
+// whole; each one between is XORed with the image before it, which leaves
+// zeros wherever nothing changed, and runs of zeros are stored as counts.
+// Going back to a tick decodes forward from the keyframe before it.
+//
+// Only what is on screen is kept: the ships, every entity pool, level,
+// score and the survival clock. Timers, the formation and the random
+// stream are not, so a rewound world is for looking at, not playing on.
+
+const char *const REWIND_DUMP_FILE = "rewind-crash.bin";
+
+struct RewindHeader
+{
+    unsigned tick;
+    int level;
+    int score;
+    int mode;
+    int coop;
+    float survivalTimer;
+    int lastBossSpawn;
+    float bossSpinAngle;
+    Player players[MAX_PLAYERS];
+    int rows[7]; // enemies, bosses, player bullets, enemy bullets, items, explosions, rings
+};
+
+inline void writeRewindImage(const World &w, std::vector<unsigned char> &out)
+{
+    RewindHeader h;
+    // Padding too, so unchanged headers XOR to zero
+    std::memset(static_cast<void *>(&h), 0, sizeof(h));
+    h.tick = w.timers.now();
+    h.level = w.level;
+    h.score = w.score;
+    h.mode = w.mode;
+    h.coop = w.coop;
+    h.survivalTimer = w.survivalTimer;
+    h.lastBossSpawn = w.lastBossSpawn;
+    h.bossSpinAngle = w.bossSpinAngle;
+    h.players[0] = w.player;
+    h.players[1] = w.player2;
+    const int rows[7] = {w.enemies.size(), w.bosses.size(), w.pBullets.size(), w.eBullets.size(),
+                         w.items.size(), w.explosions.size(), w.pickupEffects.size()};
+    std::memcpy(h.rows, rows, sizeof(rows));
+
+    out.resize(sizeof(h));
+    std::memcpy(out.data(), &h, sizeof(h));
+    // Steady pools first, so bullets coming and going shift the least
+    w.enemies.appendRows(out);
+    w.bosses.appendRows(out);
+    w.items.appendRows(out);
+    w.explosions.appendRows(out);
+    w.pickupEffects.appendRows(out);
+    w.pBullets.appendRows(out);
+    w.eBullets.appendRows(out);
+}
+
+// Back from writeRewindImage() into `w`. False, leaving `w` alone, when the
+// image doesn't add up (e.g. a dump from another build).
+inline bool readRewindImage(const std::vector<unsigned char> &image, World &w)
+{
+    RewindHeader h;
+    if (image.size() < sizeof(h))
+        return false;
+    std::memcpy(&h, image.data(), sizeof(h));
+    const std::size_t rowBytes[7] = {EnemyRows::ROW_BYTES, BossRows::ROW_BYTES, BulletRows::ROW_BYTES,
+                                     BulletRows::ROW_BYTES, ItemRows::ROW_BYTES, ExplosionRows::ROW_BYTES,
+                                     RingRows::ROW_BYTES};
+    std::size_t size = sizeof(h);
+    for (int k = 0; k < 7; ++k)
+    {
+        if (h.rows[k] < 0)
+            return false;
+        size += h.rows[k] * rowBytes[k];
+    }
+    if (size != image.size())
+        return false;
+
+    w.level = h.level;
+    w.score = h.score;
+    w.mode = (GameMode)h.mode;
+    w.coop = h.coop != 0;
+    w.survivalTimer = h.survivalTimer;
+    w.lastBossSpawn = h.lastBossSpawn;
+    w.bossSpinAngle = h.bossSpinAngle;
+    w.player = h.players[0];
+    w.player2 = h.players[1];
+    const unsigned char *in = image.data() + sizeof(h);
+    in = w.enemies.readRows(in, h.rows[0]);
+    in = w.bosses.readRows(in, h.rows[1]);
+    in = w.items.readRows(in, h.rows[4]);
+    in = w.explosions.readRows(in, h.rows[5]);
+    in = w.pickupEffects.readRows(in, h.rows[6]);
+    in = w.pBullets.readRows(in, h.rows[2]);
+    w.eBullets.readRows(in, h.rows[3]);
+    return true;
+}
+
+inline bool getVarint(const unsigned char *&p, const unsigned char *end, std::size_t &v)
+{
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        const unsigned char b = *p++;
+        v |= (std::size_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// `cur` as it differs from `prev`: its size, then pairs of (bytes that are
+// the same, bytes that aren't) with the second kind stored XORed with
+// prev. Past the end of prev counts as zeros, so against an empty prev this
+// is `cur` with its zero runs squeezed: a keyframe. `prev` is used up: it
+// is left holding the XOR.
+inline void encodeRewindDelta(std::vector<unsigned char> &prev, const std::vector<unsigned char> &cur,
+                              std::vector<unsigned char> &out)
+{
+    const std::size_t n = cur.size();
+    std::vector<unsigned char> &x = prev;
+    const std::size_t common = std::min(n, x.size());
+    x.resize(n);
+    std::size_t i = 0;
+    for (std::uint64_t a, b; i + 8 <= common; i += 8)
+    {
+        std::memcpy(&a, &x[i], 8);
+        std::memcpy(&b, &cur[i], 8);
+        a ^= b;
+        std::memcpy(&x[i], &a, 8);
+    }
+    for (; i < common; ++i)
+        x[i] ^= cur[i];
+    std::copy(cur.begin() + common, cur.end(), x.begin() + common);
+
+    // Whole words of zeros at a time; most of an image is unchanged
+    const unsigned char *d = x.data();
+    auto zerosFrom = [&](std::size_t i)
+    {
+        for (std::uint64_t word; i + 8 <= n; i += 8)
+        {
+            std::memcpy(&word, d + i, 8);
+            if (word != 0)
+                break;
+        }
+        while (i < n && d[i] == 0)
+            i++;
+        return i;
+    };
+    // First place from `i` where two bytes in a row are zero, or n; eight
+    // bytes at a time, the windows overlapping by one so no pair straddles
+    const std::uint64_t LOW7 = 0x7f7f7f7f7f7f7f7fULL;
+    auto literalEnd = [&](std::size_t i)
+    {
+        for (std::uint64_t word; i + 8 <= n; i += 7)
+        {
+            std::memcpy(&word, d + i, 8);
+            // High bit of every zero byte
+            const std::uint64_t zero = ~(((word & LOW7) + LOW7) | word | LOW7);
+            const std::uint64_t pairs = zero & (zero >> 8);
+            if (pairs != 0)
+            {
+                std::size_t k = 0;
+                while (!(pairs >> (8 * k + 7) & 1))
+                    k++;
+                return i + k;
+            }
+        }
+        while (i < n && (d[i] != 0 || (i + 1 < n && d[i + 1] != 0)))
+            i++;
+        return i;
+    };
+    auto putVarint = [](unsigned char *&p, std::size_t v)
+    {
+        for (; v >= 0x80; v >>= 7)
+            *p++ = (unsigned char)(v | 0x80);
+        *p++ = (unsigned char)v;
+    };
+
+    // Worst case: every other byte starts a pair of varints
+    out.resize(n + n / 2 + 32);
+    unsigned char *p = out.data();
+    putVarint(p, n);
+    i = 0;
+    while (i < n)
+    {
+        const std::size_t same = zerosFrom(i);
+        // A lone equal byte costs more as a run than kept in the literal
+        const std::size_t diff = literalEnd(same);
+        putVarint(p, same - i);
+        putVarint(p, diff - same);
+        std::memcpy(p, d + same, diff - same);
+        p += diff - same;
+        i = diff;
+    }
+    out.resize((std::size_t)(p - out.data()));
+}
+
+// Turn `image`, holding the image before, into the one `data` encodes
+inline bool decodeRewindDelta(const unsigned char *data, std::size_t size, std::vector<unsigned char> &image)
+{
+    const unsigned char *p = data, *end = data + size;
+    std::size_t n;
+    if (!getVarint(p, end, n))
+        return false;
+    image.resize(n, 0);
+    std::size_t i = 0;
+    while (i < n)
+    {
+        std::size_t same, diff;
+        if (!getVarint(p, end, same) || !getVarint(p, end, diff) || same > n - i || diff > n - i - same ||
+            diff > (std::size_t)(end - p))
+            return false;
+        i += same;
+        for (std::size_t k = 0; k < diff; ++k)
+            image[i++] ^= *p++;
+    }
+    return true;
+}
+
+// The last `seconds` of encoded images. The bytes go one after another
+// round a single ring that doubles whenever the frames it has to hold
+// outgrow it, so memory follows what the frames actually take and capturing
+// stops allocating once it has grown to fit.
+class RewindBuffer
+{
+public:
+    static constexpr int KEYFRAME_TICKS = 60;
+
+    // 0 seconds turns capturing off
+    explicit RewindBuffer(float seconds)
+    {
+        int ticks = (int)(seconds / TICK_SECONDS + 0.5f);
+        ticks = (ticks + KEYFRAME_TICKS - 1) / KEYFRAME_TICKS * KEYFRAME_TICKS;
+        // One more keyframe's worth: the oldest can always be decoded
+        frames.resize(ticks > 0 ? ticks + KEYFRAME_TICKS : 0);
+    }
+
+    bool isEnabled() const { return !frames.empty(); }
+    bool empty() const { return next == 0; }
+    // Frames are numbered from 0 by capture(); these two can be restored
+    long long newest() const { return next - 1; }
+    long long oldest() const
+    {
+        long long first = std::max(0LL, next - (long long)frames.size() + 1);
+        return (first + KEYFRAME_TICKS - 1) / KEYFRAME_TICKS * KEYFRAME_TICKS;
+    }
+
+    // Memory held for encoded frames
+    std::size_t bytes() const { return store.size(); }
+
+    // After every tick
+    void capture(const World &w)
+    {
+        if (!isEnabled())
+            return;
+        writeRewindImage(w, image);
+        if (next % KEYFRAME_TICKS == 0)
+            prevImage.clear();
+        encodeRewindDelta(prevImage, image, encoded);
+        std::swap(prevImage, image);
+        append(encoded);
+    }
+
+    // The world as of `frame` into `w`, a scratch world for looking at
+    bool restore(long long frame, World &w)
+    {
+        if (empty() || frame < oldest() || frame > newest())
+            return false;
+        decoded.clear();
+        for (long long k = frame - frame % KEYFRAME_TICKS; k <= frame; ++k)
+        {
+            const Frame &f = frames[k % frames.size()];
+            if (f.number != k)
+                return false;
+            contiguous.resize(f.size);
+            const std::size_t at = (std::size_t)(f.start % store.size());
+            const std::size_t first = std::min(f.size, store.size() - at);
+            std::memcpy(contiguous.data(), &store[at], first);
+            std::memcpy(contiguous.data() + first, store.data(), f.size - first);
+            if (!decodeRewindDelta(contiguous.data(), f.size, decoded))
+                return false;
+        }
+        return readRewindImage(decoded, w);
+    }
+
+    // "RWND", version, KEYFRAME_TICKS, the first frame's number and the
+    // frame count, then each frame as its size and bytes; numbers as
+    // little-endian 32 bits. This also runs from a fatal signal's handler,
+    // so it sticks to open()/write() on stack buffers: no stdio, no heap.
+    bool dump(const char *path) const
+    {
+        if (empty())
+            return false;
+        const int fd = openForDump(path);
+        if (fd < 0)
+            return false;
+        const long long first = oldest();
+        unsigned char header[20] = {'R', 'W', 'N', 'D'};
+        putU32(header + 4, DUMP_VERSION);
+        putU32(header + 8, KEYFRAME_TICKS);
+        putU32(header + 12, (std::uint32_t)first);
+        putU32(header + 16, (std::uint32_t)(next - first));
+        bool ok = writeAll(fd, header, sizeof(header));
+        for (long long k = first; ok && k < next; ++k)
+        {
+            const Frame &fr = frames[k % frames.size()];
+            // The frame a crash interrupted is written empty
+            const std::size_t size = fr.number == k ? fr.size : 0;
+            unsigned char sizeBytes[4];
+            putU32(sizeBytes, (std::uint32_t)size);
+            ok = writeAll(fd, sizeBytes, 4);
+            if (!ok || size == 0)
+                continue;
+            const std::size_t at = (std::size_t)(fr.start % store.size());
+            const std::size_t firstPart = std::min(size, store.size() - at);
+            ok = writeAll(fd, &store[at], firstPart) && writeAll(fd, store.data(), size - firstPart);
+        }
+        return closeDump(fd) && ok;
+    }
+
+    // Replace the buffer with a dump, sized to hold just that
+    bool load(const char *path)
+    {
+        std::FILE *f = std::fopen(path, "rb");
+        if (!f)
+            return false;
+        char magic[4];
+        std::uint32_t version, keyframe, first, count;
+        bool ok = std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, "RWND", 4) == 0 && readU32(f, version) &&
+                  version == DUMP_VERSION && readU32(f, keyframe) && keyframe == KEYFRAME_TICKS &&
+                  readU32(f, first) && first % KEYFRAME_TICKS == 0 && readU32(f, count);
+        if (ok)
+        {
+            frames.assign(count + KEYFRAME_TICKS, Frame());
+            store.clear();
+            head = tail = 0;
+            next = first;
+            for (std::uint32_t k = 0; ok && k < count; ++k)
+            {
+                std::uint32_t size;
+                ok = readU32(f, size) && size <= MAX_DUMP_FRAME;
+                if (ok)
+                {
+                    encoded.resize(size);
+                    ok = std::fread(encoded.data(), 1, size, f) == size;
+                    append(encoded);
+                }
+            }
+            prevImage.clear();
+        }
+        std::fclose(f);
+        return ok;
+    }
+
+private:
+    static constexpr std::uint32_t DUMP_VERSION = 2;
+    static constexpr std::uint32_t MAX_DUMP_FRAME = 64u << 20;
+
+    struct Frame
+    {
+        long long number = -1;
+        unsigned long long start = 0; // in bytes ever appended
+        std::size_t size = 0;
+    };
+
+    // Store `data` as frame `next`, over the oldest one
+    void append(const std::vector<unsigned char> &data)
+    {
+        Frame &f = frames[next % frames.size()];
+        if (f.number >= 0)
+            tail = f.start + f.size;
+        // Not readable (for a crash dump) while it is being overwritten
+        f.number = -1;
+        if (head + data.size() - tail > store.size())
+            grow(head + data.size() - tail);
+        f.start = head;
+        f.size = data.size();
+        const std::size_t at = (std::size_t)(head % store.size());
+        const std::size_t first = std::min(data.size(), store.size() - at);
+        std::memcpy(&store[at], data.data(), first);
+        std::memcpy(store.data(), data.data() + first, data.size() - first);
+        head += data.size();
+        f.number = next++;
+    }
+
+    void grow(std::size_t needed)
+    {
+        std::vector<unsigned char> bigger(std::max({needed, store.size() * 2, (std::size_t)4096}));
+        // Byte `b` of the stream sits at b % size in either ring
+        for (unsigned long long b = tail; b < head;)
+        {
+            const std::size_t from = (std::size_t)(b % store.size()), to = (std::size_t)(b % bigger.size());
+            const std::size_t run = (std::size_t)std::min<unsigned long long>(
+                {head - b, store.size() - from, bigger.size() - to});
+            std::memcpy(&bigger[to], &store[from], run);
+            b += run;
+        }
+        store.swap(bigger);
+    }
+
+    static void putU32(unsigned char *b, std::uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+            b[i] = (unsigned char)(v >> (8 * i));
+    }
+
+    // Unbuffered file writes for dump()
+#ifdef _WIN32
+    static int openForDump(const char *path)
+    {
+        return _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    }
+    static bool writeAll(int fd, const unsigned char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            const int n = _write(fd, data, (unsigned)std::min<std::size_t>(size, 1u << 30));
+            if (n <= 0)
+                return false;
+            data += n;
+            size -= (std::size_t)n;
+        }
+        return true;
+    }
+    static bool closeDump(int fd) { return _close(fd) == 0; }
+#else
+    static int openForDump(const char *path) { return open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644); }
+    static bool writeAll(int fd, const unsigned char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t n = write(fd, data, size);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            data += n;
+            size -= (std::size_t)n;
+        }
+        return true;
+    }
+    static bool closeDump(int fd) { return close(fd) == 0; }
+#endif
+
+    static bool readU32(std::FILE *f, std::uint32_t &v)
+    {
+        unsigned char b[4];
+        if (std::fread(b, 1, 4, f) != 4)
+            return false;
+        v = b[0] | (b[1] << 8) | (b[2] << 16) | ((std::uint32_t)b[3] << 24);
+        return true;
+    }
+
+    std::vector<Frame> frames;
+    long long next = 0;
+    std::vector<unsigned char> store;
+    unsigned long long head = 0, tail = 0; // [tail, head) holds the frames
+    std::vector<unsigned char> image, prevImage, encoded, decoded, contiguous;
+};
+
+// Dump `buffer` to REWIND_DUMP_FILE if the game crashes: a fatal signal or
+// an uncaught exception. Nothing here takes a lock or allocates, so a crash
+// inside malloc still gets its dump. A crashed process is in no state to
+// promise anything, though (the ring may be half written, say), so this is
+// best effort; the crash then goes on as before.
+inline RewindBuffer *rewindCrashBuffer = nullptr;
+
+inline void dumpRewindOnCrash()
+{
+    RewindBuffer *buffer = rewindCrashBuffer;
+    rewindCrashBuffer = nullptr; // once, even if dumping crashes too
+    if (!buffer || !buffer->dump(REWIND_DUMP_FILE))
+        return;
+    // write() to stderr, not stdio: its lock may be held by the crashed code
+    const char *parts[] = {"Crashed; the last seconds are in ", REWIND_DUMP_FILE, " (--rewind-view=", REWIND_DUMP_FILE, ")\n"};
+    for (const char *part : parts)
+    {
+#ifdef _WIN32
+        (void)_write(2, part, (unsigned)std::strlen(part));
+#else
+        (void)!write(2, part, std::strlen(part));
+#endif
+    }
+}
+
+inline void installRewindCrashDump(RewindBuffer &buffer)
+{
+    if (!buffer.isEnabled())
+        return;
+    rewindCrashBuffer = &buffer;
+    for (int sig : {SIGSEGV, SIGABRT, SIGFPE, SIGILL})
+        std::signal(sig, [](int sig)
+                    {
+                        dumpRewindOnCrash();
+                        std::signal(sig, SIG_DFL);
+                        std::raise(sig); });
+    static std::terminate_handler previous = std::set_terminate([]
+                                                                {
+                                                                    dumpRewindOnCrash();
+                                                                    if (previous)
+                                                                        previous();
+                                                                    std::abort(); });
+}
@@ -0,0 +1,583 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include "Game.hpp"
+#include "NetLink.hpp"
+
+// Two-player co-op over UDP with rollback, the way GGPO does it. Both
+// machines run the whole game. Each tick, a machine sends its own input and
+// simulates right away, guessing that the other player still holds what they
+// held last. When the real input arrives and differs, the world is put back
+// to the saved state of that tick and the ticks since are run again, all
+// within the same frame. Play feels local as long as the round trip stays
+// under MAX_ROLLBACK ticks; past that the game waits for the peer.
+//
+// Both sides have to compute bit-identical ticks: same build, same seed,
+// same pool sizes (the host sends its own) and the same tuning. updateWorld
+// already gives the same result on any thread count.
+
+// One player's input for one tick, as sent. moveDir is rounded to 1/127
+// steps and both machines simulate the rounded value.
+struct NetInput
+{
+    signed char move = 0;
+    unsigned char buttons = 0;
+};
+
+enum NetButton
+{
+    NET_FIRE = 1,
+    NET_FIRE_PRESSED = 2
+};
+
+inline bool operator==(const NetInput &a, const NetInput &b) { return a.move == b.move && a.buttons == b.buttons; }
+inline bool operator!=(const NetInput &a, const NetInput &b) { return !(a == b); }
+
+inline NetInput packInput(const TickInput &in)
+{
+    NetInput n;
+    n.move = (signed char)std::lround(std::max(-1.f, std::min(1.f, in.moveDir)) * 127.f);
+    n.buttons = (in.fire ? NET_FIRE : 0) | (in.firePressed ? NET_FIRE_PRESSED : 0);
+    return n;
+}
+
+inline TickInput unpackInput(const NetInput &n)
+{
+    TickInput in;
+    in.moveDir = n.move / 127.f;
+    in.fire = (n.buttons & NET_FIRE) != 0;
+    in.firePressed = (n.buttons & NET_FIRE_PRESSED) != 0;
+    return in;
+}
+
+enum NetPacket
+{
+    PACKET_HELLO = 1, // guest -> host until welcomed
+    PACKET_WELCOME,   // host -> guest: the game to play
+    PACKET_INPUTS     // both ways, every tick
+};
+
+// Little-endian writes and reads of the packet fields
+inline unsigned char *putU32(unsigned char *p, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        *p++ = (unsigned char)(v >> (8 * i));
+    return p;
+}
+
+inline const unsigned char *getU32(const unsigned char *p, std::uint32_t &v)
+{
+    v = 0;
+    for (int i = 0; i < 4; ++i)
+        v |= (std::uint32_t)*p++ << (8 * i);
+    return p;
+}
+
+// The inputs, saved states and guesses of one co-op game
+class RollbackSession
+{
+public:
+    // Ticks that may run on guessed input before the game waits for the peer
+    static constexpr int MAX_ROLLBACK = 8;
+    static constexpr int MAX_INPUT_DELAY = 8;
+    // Ticks between comparisons of the two machines' worlds
+    static constexpr int CHECK_INTERVAL = 60;
+    // Largest PACKET_INPUTS
+    static constexpr std::size_t MAX_PACKET = 32 + 2 * 64;
+
+    // Start at tick 0 from `w`, which the peer must have set up identically.
+    // Each side's input lands `inputDelay` ticks after it was read, which
+    // buys the network that much time before a guess is needed.
+    void start(const World &w, int localPlayer, int inputDelay)
+    {
+        local = localPlayer;
+        remote = 1 - localPlayer;
+        delay = std::max(0, std::min(MAX_INPUT_DELAY, inputDelay));
+        // Sized now, so saving a tick only copies
+        for (World &s : states)
+            s = w;
+        for (auto &ring : inputs)
+            std::fill(ring, ring + INPUT_RING, NetInput());
+        current = 0;
+        // Nobody has input for the first `delay` ticks; both sides know it
+        remoteNext = localNext = (unsigned)delay;
+        peerAck = 0;
+        peerTick = 0;
+        remoteAdvantage = 0;
+        rollbackTo = NONE;
+        nextSettle = 0;
+        over = false;
+        overTick = 0;
+        desync = false;
+        lastCheck = remoteCheck = {NONE, 0};
+        std::fill(checks, checks + CHECKS, Check{NONE, 0});
+        rollbacks = replayedTicks = deepest = 0;
+    }
+
+    // Next tick to simulate
+    unsigned tick() const { return current; }
+
+    // False once MAX_ROLLBACK ticks run on guesses: wait for the peer
+    bool canAdvance() const { return !over && current < remoteNext + MAX_ROLLBACK; }
+
+    // Simulate one tick, `in` being this machine's player's input. Corrected
+    // guesses are rolled back first. `ev` gets the new tick's events only;
+    // ticks run again don't repeat their sounds.
+    void advance(World &w, const TickInput &in, JobSystem &jobs, TickEvents &ev)
+    {
+        inputs[local][(current + delay) & RING_MASK] = packInput(in);
+        localNext = current + delay + 1;
+        catchUp(w, jobs);
+        if (over)
+            return;
+        simulate(w, current, jobs, ev);
+        current++;
+    }
+
+    // Roll back and replay whatever the inputs received so far corrected,
+    // without running a new tick
+    void catchUp(World &w, JobSystem &jobs)
+    {
+        if (over)
+            return;
+        if (rollbackTo < current)
+        {
+            w = states[rollbackTo % STATES];
+            TickEvents replayed;
+            for (unsigned t = rollbackTo; t < current; ++t)
+                simulate(w, t, jobs, replayed);
+            rollbacks++;
+            replayedTicks += current - rollbackTo;
+            deepest = std::max(deepest, current - rollbackTo);
+        }
+        rollbackTo = NONE;
+        settle(w);
+    }
+
+    // Every ship down in a tick both sides agree on. The world is left as
+    // it was right after that tick, the same on both machines.
+    bool isOver() const { return over; }
+    unsigned overAt() const { return overTick; }
+    // Every tick so far ran on the peer's real input
+    bool confirmed() const { return remoteNext >= current; }
+    // The two worlds differed at some CHECK_INTERVAL tick
+    bool desynced() const { return desync; }
+
+    // How many ticks this side runs ahead of the peer, from both sides'
+    // view so the network delay cancels out
+    int ticksAhead() const
+    {
+        const int advantage = (int)current - (int)peerTick;
+        return (advantage - remoteAdvantage) / 2;
+    }
+
+    unsigned rollbackCount() const { return rollbacks; }
+    unsigned replayedTickCount() const { return replayedTicks; }
+    unsigned deepestRollback() const { return deepest; }
+
+    // PACKET_INPUTS: what the peer still needs of this side's inputs (all
+    // of it, again, until it says it has them), plus this side's tick and
+    // newest checksum. Returns the size.
+    std::size_t writeInputs(unsigned char *out) const
+    {
+        unsigned first = std::max(peerAck, localNext > INPUT_RING ? localNext - INPUT_RING : 0u);
+        const unsigned count = localNext > first ? localNext - first : 0u;
+        unsigned char *p = out;
+        *p++ = PACKET_INPUTS;
+        p = putU32(p, remoteNext);
+        p = putU32(p, current);
+        *p++ = (unsigned char)(signed char)std::max(-127, std::min(127, (int)current - (int)peerTick));
+        p = putU32(p, lastCheck.tick);
+        p = putU32(p, (std::uint32_t)lastCheck.sum);
+        p = putU32(p, (std::uint32_t)(lastCheck.sum >> 32));
+        p = putU32(p, first);
+        *p++ = (unsigned char)count;
+        for (unsigned t = first; t < first + count; ++t)
+        {
+            const NetInput &n = inputs[local][t & RING_MASK];
+            *p++ = (unsigned char)n.move;
+            *p++ = n.buttons;
+        }
+        return (std::size_t)(p - out);
+    }
+
+    // Take in a PACKET_INPUTS from the peer. A new input for a tick that
+    // already ran on a guess marks the tick to roll back to; the next
+    // advance() or catchUp() does it.
+    void readInputs(const unsigned char *data, std::size_t size)
+    {
+        if (size < HEADER_SIZE || data[0] != PACKET_INPUTS)
+            return;
+        const unsigned char *p = data + 1;
+        std::uint32_t ack, tick, checkTick, sumLow, sumHigh, first;
+        p = getU32(p, ack);
+        p = getU32(p, tick);
+        const int advantage = (signed char)*p++;
+        p = getU32(p, checkTick);
+        p = getU32(p, sumLow);
+        p = getU32(p, sumHigh);
+        p = getU32(p, first);
+        const unsigned count = *p++;
+        if (size < HEADER_SIZE + 2 * count)
+            return;
+
+        peerAck = std::max(peerAck, (unsigned)ack);
+        // Datagrams can come out of order; only the newest says where the peer is
+        if (tick >= peerTick)
+        {
+            peerTick = tick;
+            remoteAdvantage = advantage;
+        }
+        if (checkTick != NONE)
+        {
+            remoteCheck = {checkTick, ((unsigned long long)sumHigh << 32) | sumLow};
+            compareCheck();
+        }
+
+        for (unsigned k = 0; k < count; ++k, p += 2)
+        {
+            const unsigned t = first + k;
+            if (t < remoteNext)
+                continue; // had it already
+            if (t > remoteNext)
+                break; // a gap; it is sent again
+            NetInput n;
+            n.move = (signed char)p[0];
+            n.buttons = p[1];
+            NetInput &slot = inputs[remote][t & RING_MASK];
+            if (t < current && slot != n)
+                rollbackTo = std::min(rollbackTo, t);
+            slot = n;
+            remoteNext++;
+        }
+    }
+
+private:
+    static constexpr unsigned NONE = UINT_MAX;
+    // Saved states: the last MAX_ROLLBACK ticks, and the one before them
+    static constexpr int STATES = MAX_ROLLBACK + 1;
+    // Inputs kept per player; covers every tick either side can still ask for
+    static constexpr unsigned INPUT_RING = 64;
+    static constexpr unsigned RING_MASK = INPUT_RING - 1;
+    static constexpr std::size_t HEADER_SIZE = 1 + 4 + 4 + 1 + 4 + 8 + 4 + 1;
+    static constexpr int CHECKS = 8;
+
+    struct Check
+    {
+        unsigned tick;
+        unsigned long long sum;
+    };
+
+    void simulate(World &w, unsigned t, JobSystem &jobs, TickEvents &ev)
+    {
+        states[t % STATES] = w;
+        if (t >= remoteNext)
+        {
+            // Guess: still holding what they held, but no new press
+            NetInput guess = inputs[remote][(remoteNext - 1) & RING_MASK];
+            guess.buttons &= ~NET_FIRE_PRESSED;
+            inputs[remote][t & RING_MASK] = guess;
+        }
+        TickInput in[MAX_PLAYERS];
+        for (int p = 0; p < MAX_PLAYERS; ++p)
+            in[p] = unpackInput(inputs[p][t & RING_MASK]);
+        updateWorld(w, in, TICK_SECONDS, jobs, ev);
+    }
+
+    // Go through the ticks that can't change any more: every input before
+    // them is in. Their checksums are what gets compared with the peer.
+    void settle(World &w)
+    {
+        const unsigned frontier = std::min(remoteNext, current);
+        for (; nextSettle <= frontier && !over; ++nextSettle)
+        {
+            const unsigned t = nextSettle;
+            const World &s = t == current ? w : states[t % STATES];
+            if (t % CHECK_INTERVAL == 0)
+            {
+                lastCheck = {t, worldChecksum(s)};
+                checks[(t / CHECK_INTERVAL) % CHECKS] = lastCheck;
+                compareCheck();
+            }
+            if (playersDown(s))
+            {
+                over = true;
+                overTick = t;
+                if (&s != &w)
+                    w = s;
+            }
+        }
+    }
+
+    void compareCheck()
+    {
+        const Check &mine = checks[(remoteCheck.tick / CHECK_INTERVAL) % CHECKS];
+        if (remoteCheck.tick != NONE && mine.tick == remoteCheck.tick && mine.sum != remoteCheck.sum && !desync)
+        {
+            desync = true;
+            std::cout << "[net] the two games differ from tick " << mine.tick << " on\n";
+        }
+    }
+
+    int local = 0, remote = 1;
+    int delay = 0;
+    World states[STATES];
+    NetInput inputs[MAX_PLAYERS][INPUT_RING];
+    unsigned current = 0;    // next tick to simulate
+    unsigned remoteNext = 0; // first tick without the peer's input
+    unsigned localNext = 0;  // first tick without this side's input
+    unsigned peerAck = 0;    // first tick the peer lacks of this side's
+    unsigned peerTick = 0;
+    int remoteAdvantage = 0;
+    unsigned rollbackTo = NONE;
+    unsigned nextSettle = 0;
+    bool over = false;
+    unsigned overTick = 0;
+    bool desync = false;
+    Check lastCheck{NONE, 0}, remoteCheck{NONE, 0};
+    Check checks[CHECKS];
+    unsigned rollbacks = 0, replayedTicks = 0, deepest = 0;
+};
+
+const unsigned short DEFAULT_NET_PORT = 7777;
+const std::uint32_t NET_VERSION = 1;
+
+// What the host decides and the guest plays by
+struct NetGame
+{
+    unsigned seed = 0;
+    GameMode mode = MODE_NORMAL;
+    Capacities caps;
+    int inputDelay = 2;
+    unsigned tuningSum = 0;
+};
+
+// The connection and the session on top of it. The host is player 1 and
+// picks the game; the guest is player 2.
+class Netplay
+{
+public:
+    // A side ahead of the peer sits out at most one tick in this many
+    static constexpr unsigned WAIT_SPACING = 8;
+    static constexpr double HELLO_SECONDS = 0.25;
+    static constexpr double KEEPALIVE_SECONDS = 0.05;
+    static constexpr double PEER_TIMEOUT_SECONDS = 5.0;
+
+    ~Netplay() { stop(); }
+
+    // Wait on `port` for a guest
+    bool host(unsigned short port, const NetGame &g, const NetConditions &c)
+    {
+        stop();
+        if (!link.listen(port))
+            return false;
+        link.setConditions(c);
+        game = g;
+        role = ROLE_HOST;
+        std::cout << "Waiting for player 2 on port " << port << "\n";
+        return true;
+    }
+
+    bool join(const sf::IpAddress &address, unsigned short port, const NetConditions &c)
+    {
+        stop();
+        if (address == sf::IpAddress::None || !link.connect(address, port))
+            return false;
+        link.setConditions(c);
+        role = ROLE_GUEST;
+        lastHello = Clock::time_point();
+        std::cout << "Joining " << address.toString() << ":" << port << "\n";
+        return true;
+    }
+
+    bool isActive() const { return role != ROLE_NONE; }
+    // Both sides know the game; call begin() to start playing it
+    bool isReady() const { return ready; }
+    bool hasBegun() const { return begun; }
+    int localPlayer() const { return role == ROLE_GUEST ? 1 : 0; }
+    const NetGame &netGame() const { return game; }
+    RollbackSession &session() { return rollback; }
+
+    // Start the session on `w`, set up from netGame() the same way on both sides
+    void begin(const World &w)
+    {
+        rollback.start(w, localPlayer(), game.inputDelay);
+        begun = true;
+        waitedAt = 0;
+        waits = 0;
+        lastHeard = Clock::now();
+    }
+
+    // Once per frame: read what arrived, then send what is due
+    void poll()
+    {
+        if (!isActive())
+            return;
+        unsigned char data[NetLink::MAX_DATAGRAM];
+        std::size_t size = 0;
+        while (link.receive(data, size))
+        {
+            if (size == 0)
+                continue;
+            lastHeard = Clock::now();
+            handle(data, size);
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (role == ROLE_GUEST && !ready && now - lastHello >= seconds(HELLO_SECONDS))
+        {
+            unsigned char hello[8];
+            hello[0] = PACKET_HELLO;
+            putU32(hello + 1, NET_VERSION);
+            link.send(hello, 5);
+            lastHello = now;
+        }
+        if (begun && (rollback.tick() != sentTick || now - lastSend >= seconds(KEEPALIVE_SECONDS)))
+        {
+            unsigned char packet[RollbackSession::MAX_PACKET];
+            link.send(packet, rollback.writeInputs(packet));
+            sentTick = rollback.tick();
+            lastSend = now;
+        }
+    }
+
+    // Nothing from the peer for PEER_TIMEOUT_SECONDS
+    bool peerLost() const { return begun && Clock::now() - lastHeard >= seconds(PEER_TIMEOUT_SECONDS); }
+
+    // Whether to sit this tick out: as many ticks run on guesses as allowed,
+    // or this side runs ahead of the peer (then only now and then, so both
+    // drift back together without a visible hitch)
+    bool shouldWait()
+    {
+        if (!rollback.canAdvance())
+        {
+            waits++;
+            return true;
+        }
+        if (rollback.ticksAhead() < 2 || rollback.tick() < waitedAt + WAIT_SPACING)
+            return false;
+        waitedAt = rollback.tick();
+        waits++;
+        return true;
+    }
+
+    void stop()
+    {
+        if (begun)
+            std::cout << "[net] " << rollback.rollbackCount() << " rollbacks, " << rollback.replayedTickCount()
+                      << " ticks run again (deepest " << rollback.deepestRollback() << "), " << waits
+                      << " ticks waited for the peer\n";
+        link.close();
+        role = ROLE_NONE;
+        ready = begun = false;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum Role
+    {
+        ROLE_NONE,
+        ROLE_HOST,
+        ROLE_GUEST
+    };
+
+    static Clock::duration seconds(double s)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+    }
+
+    void handle(const unsigned char *data, std::size_t size)
+    {
+        switch (data[0])
+        {
+        case PACKET_HELLO:
+        {
+            std::uint32_t version = 0;
+            if (role != ROLE_HOST || size < 5 || (getU32(data + 1, version), version != NET_VERSION))
+                return;
+            if (!ready)
+                std::cout << "Player 2 joined\n";
+            ready = true;
+            // Again for every hello, in case the last welcome was lost
+            sendWelcome();
+            break;
+        }
+        case PACKET_WELCOME:
+            if (role == ROLE_GUEST && !ready && readWelcome(data, size))
+            {
+                ready = true;
+                std::cout << "Joined as player 2\n";
+                if (game.tuningSum != tuningChecksum(tuning))
+                    std::cout << "[net] " << TUNING_FILE << " differs from the host's; the games will drift apart\n";
+            }
+            break;
+        case PACKET_INPUTS:
+            if (begun)
+                rollback.readInputs(data, size);
+            break;
+        }
+    }
+
+    void sendWelcome()
+    {
+        unsigned char packet[64];
+        unsigned char *p = packet;
+        *p++ = PACKET_WELCOME;
+        p = putU32(p, game.seed);
+        *p++ = (unsigned char)game.mode;
+        *p++ = (unsigned char)game.inputDelay;
+        p = putU32(p, game.tuningSum);
+        for (int v : {game.caps.enemies, game.caps.pBullets, game.caps.eBullets, game.caps.items,
+                      game.caps.explosions, game.caps.pickupEffects})
+            p = putU32(p, (std::uint32_t)v);
+        link.send(packet, (std::size_t)(p - packet));
+    }
+
+    // Taken only if it describes a game this build can set up: a known
+    // mode, pool sizes within MAX_CAPACITIES and an input delay it allows.
+    // Anything else is a broken or hostile datagram, and is dropped.
+    bool readWelcome(const unsigned char *data, std::size_t size)
+    {
+        if (size < 1 + 4 + 1 + 1 + 4 + 6 * 4)
+            return false;
+        const unsigned char *p = data + 1;
+        NetGame g;
+        std::uint32_t v;
+        p = getU32(p, v);
+        g.seed = v;
+        const unsigned char mode = *p++;
+        if (mode > MODE_STRESS)
+            return false;
+        g.mode = (GameMode)mode;
+        g.inputDelay = *p++;
+        if (g.inputDelay > RollbackSession::MAX_INPUT_DELAY)
+            return false;
+        p = getU32(p, v);
+        g.tuningSum = v;
+        for (int *cap : {&g.caps.enemies, &g.caps.pBullets, &g.caps.eBullets, &g.caps.items,
+                         &g.caps.explosions, &g.caps.pickupEffects})
+        {
+            p = getU32(p, v);
+            // Past INT_MAX reads as negative, which the range check turns away
+            *cap = (int)v;
+        }
+        if (!capacitiesInRange(g.caps))
+            return false;
+        game = g;
+        return true;
+    }
+
+    NetLink link;
+    RollbackSession rollback;
+    NetGame game;
+    Role role = ROLE_NONE;
+    bool ready = false, begun = false;
+    unsigned sentTick = UINT_MAX;
+    unsigned waitedAt = 0, waits = 0;
+    Clock::time_point lastHello, lastSend, lastHeard;
+};
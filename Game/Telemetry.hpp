@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Playtest telemetry: one JSON object per line (NDJSON), so files from many
+// machines and builds can be concatenated and charted. The game only hands
+// over numbers; percentiles, formatting and the disk writes happen on a
+// background thread.
+//
+//   {"type":"session","build":"...","threads":N,"pacing":"..."}
+//   {"type":"period","mode":"normal","level":N,...}  once per level, or
+//   {"type":"period","mode":"survival","minute":N,...} once per survival minute
+//   {"type":"save","slot":N,"ms":...,"ok":true}       and "load" alike
+//   {"type":"end","seconds":...}
+
+enum TelemetryPool
+{
+    POOL_ENEMIES, // bosses included
+    POOL_P_BULLETS,
+    POOL_E_BULLETS,
+    POOL_ITEMS,
+    POOL_EXPLOSIONS,
+    TELEMETRY_POOLS
+};
+
+// One level, or one minute of survival
+struct TelemetryPeriod
+{
+    std::string mode;
+    int level = 0;
+    int minute = -1; // survival only
+    double seconds = 0.0;
+    std::vector<float> frameMs;
+    std::vector<unsigned> frameAllocs;
+    int ticks = 0;
+    double tickUsSum = 0.0;
+    float tickUsMax = 0.f;
+    double liveSum[TELEMETRY_POOLS] = {};
+    int liveMax[TELEMETRY_POOLS] = {};
+    unsigned drops[TELEMETRY_POOLS] = {};
+};
+
+class Telemetry
+{
+public:
+    ~Telemetry() { close(); }
+
+    // Start writing to `path`; until then every call is a no-op
+    bool open(const std::string &path, const std::string &build, int threads, const char *pacing)
+    {
+        file = std::fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        started = Clock::now();
+        writer = std::thread([this]
+                             { run(); });
+        post("{\"type\":\"session\",\"build\":\"" + build + "\",\"threads\":" + std::to_string(threads) +
+             ",\"pacing\":\"" + pacing + "\"}");
+        return true;
+    }
+
+    bool isEnabled() const { return file != nullptr; }
+
+    // Close the open period, write the last line and wait for the disk
+    void close()
+    {
+        if (!writer.joinable())
+            return;
+        endPeriod(lastRefused);
+        post("{\"type\":\"end\",\"seconds\":" + number(secondsSince(started)) + "}");
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    // The period being played. A different mode, level or minute closes the
+    // current one; `refused` are the pools' refused spawns so far. True when
+    // this started a new period.
+    bool enterPeriod(const char *mode, int level, int minute, const unsigned (&refused)[TELEMETRY_POOLS])
+    {
+        if (!isEnabled())
+            return false;
+        std::copy(refused, refused + TELEMETRY_POOLS, lastRefused);
+        if (current && current->mode == mode && current->level == level && current->minute == minute)
+            return false;
+        endPeriod(refused);
+        current.reset(new TelemetryPeriod());
+        current->mode = mode;
+        current->level = level;
+        current->minute = minute;
+        std::copy(refused, refused + TELEMETRY_POOLS, periodRefused);
+        periodStart = Clock::now();
+        return true;
+    }
+
+    // Left the game (game over, back to the menu)
+    void endPeriod(const unsigned (&refused)[TELEMETRY_POOLS])
+    {
+        if (!current)
+            return;
+        for (int p = 0; p < TELEMETRY_POOLS; ++p)
+            current->drops[p] = refused[p] - periodRefused[p];
+        current->seconds = secondsSince(periodStart);
+        {
+            std::lock_guard<std::mutex> lock(frameLock);
+            current->frameMs.swap(frameMs);
+            current->frameAllocs.swap(frameAllocs);
+            frameMs.clear();
+            frameAllocs.clear();
+        }
+        post(std::string(), std::move(current));
+    }
+
+    // Main thread, after each simulation tick
+    void onTick(float tickUs, const int (&live)[TELEMETRY_POOLS])
+    {
+        if (!current)
+            return;
+        current->ticks++;
+        current->tickUsSum += tickUs;
+        current->tickUsMax = std::max(current->tickUsMax, tickUs);
+        for (int p = 0; p < TELEMETRY_POOLS; ++p)
+        {
+            current->liveSum[p] += live[p];
+            current->liveMax[p] = std::max(current->liveMax[p], live[p]);
+        }
+    }
+
+    // Whichever thread presents game frames, once per frame. `allocsSoFar`
+    // is the running count of heap allocations, from every thread.
+    void onFrame(float frameSeconds, unsigned long long allocsSoFar)
+    {
+        if (!isEnabled())
+            return;
+        std::lock_guard<std::mutex> lock(frameLock);
+        if (lastAllocs != 0)
+        {
+            frameMs.push_back(frameSeconds * 1000.f);
+            frameAllocs.push_back((unsigned)(allocsSoFar - lastAllocs));
+        }
+        lastAllocs = allocsSoFar;
+    }
+
+    // No game frames for a while (paused, in a menu): the next frame starts
+    // the allocation count afresh instead of billing it for the gap
+    void framesStopped()
+    {
+        std::lock_guard<std::mutex> lock(frameLock);
+        lastAllocs = 0;
+    }
+
+    // `what` is "save" or "load"
+    void onSaveLoad(const char *what, int slot, float ms, bool ok)
+    {
+        if (!isEnabled())
+            return;
+        post(std::string("{\"type\":\"") + what + "\",\"slot\":" + std::to_string(slot) +
+             ",\"ms\":" + number(ms) + ",\"ok\":" + (ok ? "true" : "false") + "}");
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Item
+    {
+        std::string line;
+        std::unique_ptr<TelemetryPeriod> period; // formatted by the writer
+    };
+
+    static double secondsSince(Clock::time_point t)
+    {
+        return std::chrono::duration<double>(Clock::now() - t).count();
+    }
+
+    static std::string number(double v)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof buf, "%.3f", v);
+        return buf;
+    }
+
+    template <typename T>
+    static std::string spread(std::vector<T> v)
+    {
+        if (v.empty())
+            return "null";
+        std::sort(v.begin(), v.end());
+        double sum = 0.0;
+        for (T x : v)
+            sum += x;
+        auto at = [&](double q)
+        { return (double)v[std::min(v.size() - 1, (std::size_t)(q * v.size()))]; };
+        return "{\"mean\":" + number(sum / v.size()) + ",\"p50\":" + number(at(0.5)) + ",\"p90\":" + number(at(0.9)) +
+               ",\"p99\":" + number(at(0.99)) + ",\"max\":" + number(v.back()) + "}";
+    }
+
+    static std::string format(const TelemetryPeriod &p)
+    {
+        static const char *POOL_NAMES[TELEMETRY_POOLS] = {"enemies", "player_bullets", "enemy_bullets", "items", "explosions"};
+        std::string s = "{\"type\":\"period\",\"mode\":\"" + p.mode + "\",";
+        s += p.minute >= 0 ? "\"minute\":" + std::to_string(p.minute) : "\"level\":" + std::to_string(p.level);
+        s += ",\"seconds\":" + number(p.seconds) + ",\"frames\":" + std::to_string(p.frameMs.size());
+        s += ",\"frame_ms\":" + spread(p.frameMs);
+        s += ",\"allocs_per_frame\":" + spread(p.frameAllocs);
+        s += ",\"ticks\":" + std::to_string(p.ticks);
+        s += ",\"tick_us\":{\"mean\":" + number(p.ticks ? p.tickUsSum / p.ticks : 0.0) + ",\"max\":" + number(p.tickUsMax) + "}";
+        s += ",\"live\":{";
+        for (int i = 0; i < TELEMETRY_POOLS; ++i)
+            s += std::string(i ? "," : "") + "\"" + POOL_NAMES[i] + "\":{\"mean\":" + number(p.ticks ? p.liveSum[i] / p.ticks : 0.0) +
+                 ",\"max\":" + std::to_string(p.liveMax[i]) + "}";
+        s += "},\"drops\":{";
+        for (int i = 0; i < TELEMETRY_POOLS; ++i)
+            s += std::string(i ? "," : "") + "\"" + POOL_NAMES[i] + "\":" + std::to_string(p.drops[i]);
+        return s + "}}";
+    }
+
+    void post(std::string line, std::unique_ptr<TelemetryPeriod> period = nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueLock);
+            queue.push_back({std::move(line), std::move(period)});
+        }
+        wake.notify_one();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(queueLock);
+        for (;;)
+        {
+            wake.wait(lock, [this]
+                      { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return; // stopping, and everything written
+            Item item = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            const std::string line = item.period ? format(*item.period) : item.line;
+            std::fputs(line.c_str(), file);
+            std::fputc('\n', file);
+            // A crash loses at most the line being written
+            std::fflush(file);
+            lock.lock();
+        }
+    }
+
+    std::FILE *file = nullptr;
+    std::thread writer;
+    std::mutex queueLock;
+    std::condition_variable wake;
+    std::deque<Item> queue;
+    bool stopping = false;
+
+    // Main thread only
+    std::unique_ptr<TelemetryPeriod> current;
+    unsigned periodRefused[TELEMETRY_POOLS] = {};
+    unsigned lastRefused[TELEMETRY_POOLS] = {};
+    Clock::time_point started, periodStart;
+
+    // Filled by the presenting thread, taken at the end of each period
+    std::mutex frameLock;
+    std::vector<float> frameMs;
+    std::vector<unsigned> frameAllocs;
+    unsigned long long lastAllocs = 0;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+
+// Events of type T, each due at a simulation tick. advance() moves time on
+// by one tick and hands out what is due, so a tick costs the events that
+// come due in it rather than one countdown per timer.
+//
+// Four levels of 64 slots: level 0 holds the next 64 ticks one slot per
+// tick, level 1 the next 64*64 in slots of 64 ticks, and so on. When level 0
+// wraps, the next slot of level 1 is spread back over level 0, and likewise
+// up the levels. Anything past the top level waits in its last slot and is
+// put back in place as it comes round.
+template <typename T>
+class TimerWheel
+{
+public:
+    static const int LEVEL_BITS = 6;
+    static const int SLOTS = 1 << LEVEL_BITS;
+    static const int LEVELS = 4;
+
+    // The last tick advance() handed out; 0 before the first
+    unsigned now() const { return current; }
+    int pending() const { return count; }
+
+    // `ev` comes due at `tick`; a tick that has already passed means the
+    // next one
+    void schedule(unsigned tick, const T &ev)
+    {
+        if ((int)(tick - current) <= 0)
+            tick = current + 1;
+        place({tick, ev});
+        count++;
+    }
+
+    // Move on one tick and append its events to `due`. Events of one tick
+    // come out in a fixed order, so replays with the same schedule match.
+    void advance(std::vector<T> &due)
+    {
+        current++;
+        // Carry down every level whose slot index just wrapped to 0
+        for (int level = 1; level < LEVELS; ++level)
+        {
+            if (((current >> ((level - 1) * LEVEL_BITS)) & (SLOTS - 1)) != 0)
+                break;
+            cascade(level, (current >> (level * LEVEL_BITS)) & (SLOTS - 1));
+        }
+        std::vector<Entry> &slot = slots[0][current & (SLOTS - 1)];
+        for (const Entry &e : slot)
+            due.push_back(e.ev);
+        count -= (int)slot.size();
+        slot.clear();
+    }
+
+    // Room for `perSlot` events in every slot up front, so a game doesn't
+    // start by growing them one by one
+    void reserve(int perSlot)
+    {
+        for (auto &level : slots)
+            for (std::vector<Entry> &slot : level)
+                slot.reserve(perSlot);
+        scratch.reserve(perSlot);
+    }
+
+    // Drop every event; time keeps counting from where it is
+    void clear()
+    {
+        for (auto &level : slots)
+            for (std::vector<Entry> &slot : level)
+                slot.clear();
+        count = 0;
+    }
+
+private:
+    struct Entry
+    {
+        unsigned tick;
+        T ev;
+    };
+
+    void place(const Entry &e)
+    {
+        unsigned delta = e.tick - current;
+        for (int level = 0; level < LEVELS; ++level)
+        {
+            if (delta < (1u << ((level + 1) * LEVEL_BITS)))
+            {
+                slots[level][(e.tick >> (level * LEVEL_BITS)) & (SLOTS - 1)].push_back(e);
+                return;
+            }
+        }
+        // Too far off for the top level: park it in the slot it reaches last
+        const int top = LEVELS - 1;
+        slots[top][((current >> (top * LEVEL_BITS)) - 1) & (SLOTS - 1)].push_back(e);
+    }
+
+    void cascade(int level, unsigned index)
+    {
+        // Copy out first: place() may push into the level being emptied.
+        // Copying rather than swapping leaves every slot its own capacity,
+        // so once the slots have grown to fit, ticks stop allocating.
+        std::vector<Entry> &slot = slots[level][index];
+        scratch.assign(slot.begin(), slot.end());
+        slot.clear();
+        for (const Entry &e : scratch)
+            place(e);
+    }
+
+    std::vector<Entry> slots[LEVELS][SLOTS];
+    std::vector<Entry> scratch;
+    unsigned current = 0;
+    int count = 0;
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#else
+#include <filesystem>
+#include <SFML/System/Clock.hpp>
+#endif
+
+// Balancing values that can be changed while the game is running.
+// Kept in one cache line so the hot loops read them for free.
+struct alignas(64) Tuning
+{
+    float playerSpeed = 300.0f;
+
+    // Bullet
+    float pBulletSpeed = 520.0f;
+    float eBulletSpeed = 240.0f;
+
+    // Team/formation move
+    float formSpeed = 90.f;
+    float formMargin = 60.0f;
+    float formDropY = 24.f;
+
+    // Formation layout
+    float formStartX = 120.f;
+    float formStartY = 110.f;
+    float formGapX = 110.f;
+    float formGapY = 70.f;
+
+    // MISC
+    float enemyFireBaseCooldown = 2.5f;
+    float itemFallSpeed = 120.0f;
+    int dropChancePercent = 36;
+
+    // EFFECTS
+    float explosionFrameDuration = 0.05f;
+    float effectExpandSpeed = 200.f;
+    float effectFadeSpeed = 500.f;
+};
+static_assert(sizeof(Tuning) == 64, "Tuning should stay within one cache line");
+
+inline Tuning tuning;
+
+const char *const TUNING_FILE = "Tuning.txt";
+
+// Hash of the values, to tell whether two machines play by the same ones
+inline unsigned tuningChecksum(const Tuning &t)
+{
+    // Up to the last field: the padding after it is never written
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&t);
+    unsigned h = 2166136261u;
+    for (std::size_t i = 0; i < offsetof(Tuning, effectFadeSpeed) + sizeof(t.effectFadeSpeed); ++i)
+        h = (h ^ bytes[i]) * 16777619u;
+    return h;
+}
+
+// Parse "KEY value" lines ('#' starts a comment). On any error `out` is left untouched.
+inline bool loadTuning(const std::string &path, Tuning &out)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+        return false;
+
+    Tuning t = out;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line))
+    {
+        lineNo++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+
+        std::istringstream ss(line);
+        std::string key;
+        if (!(ss >> key))
+            continue;
+
+        float value;
+        if (!(ss >> value))
+        {
+            std::cout << path << ":" << lineNo << ": missing value for " << key << "\n";
+            return false;
+        }
+
+        if (key == "PLAYER_SPEED")
+            t.playerSpeed = value;
+        else if (key == "P_BULLET_SPEED")
+            t.pBulletSpeed = value;
+        else if (key == "E_BULLET_SPEED")
+            t.eBulletSpeed = value;
+        else if (key == "FORM_SPEED")
+            t.formSpeed = value;
+        else if (key == "FORM_MARGIN")
+            t.formMargin = value;
+        else if (key == "FORM_DROP_Y")
+            t.formDropY = value;
+        else if (key == "FORM_START_X")
+            t.formStartX = value;
+        else if (key == "FORM_START_Y")
+            t.formStartY = value;
+        else if (key == "FORM_GAP_X")
+            t.formGapX = value;
+        else if (key == "FORM_GAP_Y")
+            t.formGapY = value;
+        else if (key == "ENEMY_FIRE_BASE_COOLDOWN")
+            t.enemyFireBaseCooldown = value;
+        else if (key == "ITEM_FALL_SPEED")
+            t.itemFallSpeed = value;
+        else if (key == "DROP_CHANCE_PERCENT")
+            t.dropChancePercent = (int)value;
+        else if (key == "EXPLOSION_FRAME_DURATION")
+            t.explosionFrameDuration = value;
+        else if (key == "EFFECT_EXPAND_SPEED")
+            t.effectExpandSpeed = value;
+        else if (key == "EFFECT_FADE_SPEED")
+            t.effectFadeSpeed = value;
+        else
+            std::cout << path << ":" << lineNo << ": unknown key " << key << "\n";
+    }
+
+    // A cooldown or frame time of 0 would make the game spin
+    if (t.enemyFireBaseCooldown <= 0.f || t.explosionFrameDuration <= 0.f)
+    {
+        std::cout << path << ": cooldowns and frame durations must be > 0\n";
+        return false;
+    }
+
+    out = t;
+    return true;
+}
+
+// Tells the game loop when the tuning file has been rewritten.
+// Linux uses inotify on the working directory (editors often save by rename,
+// so the file itself can't be watched); other platforms poll the file time.
+class TuningWatcher
+{
+public:
+    explicit TuningWatcher(const std::string &fileName) : fileName(fileName)
+    {
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd >= 0 && inotify_add_watch(fd, ".", IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+        {
+            std::cout << "inotify_add_watch failed: " << std::strerror(errno) << "\n";
+            close(fd);
+            fd = -1;
+        }
+#else
+        std::error_code ec;
+        lastWrite = std::filesystem::last_write_time(fileName, ec);
+#endif
+    }
+
+    ~TuningWatcher()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    TuningWatcher(const TuningWatcher &) = delete;
+    TuningWatcher &operator=(const TuningWatcher &) = delete;
+
+    // Non-blocking; returns true once per change of the file.
+    bool poll()
+    {
+#ifdef __linux__
+        if (fd < 0)
+            return false;
+        bool changed = false;
+        alignas(inotify_event) char buf[4096];
+        for (;;)
+        {
+            ssize_t len = read(fd, buf, sizeof(buf));
+            if (len <= 0)
+                break;
+            for (char *p = buf; p < buf + len;)
+            {
+                const inotify_event *ev = reinterpret_cast<const inotify_event *>(p);
+                if (ev->len > 0 && fileName == ev->name)
+                    changed = true;
+                p += sizeof(inotify_event) + ev->len;
+            }
+        }
+        return changed;
+#else
+        // Checking the file time is a syscall, so only do it a few times per second
+        if (pollClock.getElapsedTime().asSeconds() < 0.5f)
+            return false;
+        pollClock.restart();
+        std::error_code ec;
+        auto t = std::filesystem::last_write_time(fileName, ec);
+        if (ec || t == lastWrite)
+            return false;
+        lastWrite = t;
+        return true;
+#endif
+    }
+
+private:
+    std::string fileName;
+#ifdef __linux__
+    int fd = -1;
+#else
+    std::filesystem::file_time_type lastWrite;
+    sf::Clock pollClock;
+#endif
+};
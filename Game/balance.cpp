@@ -0,0 +1,457 @@
+// Monte-Carlo balance runner: plays thousands of headless games with an
+// autopilot and reports how far they get.
+//
+// Build and run from this folder, e.g.
+//   g++ -std=c++17 -O2 -pthread balance.cpp -o balance -lsfml-system
+//   ./balance --games=2000 --mode=all > balance.json
+//
+// Flags:
+//   --games=N        games per mode (default 1000)
+//   --mode=M         normal, hard, survival or all (default all)
+//   --pilot=P        dodge (reads the screen) or sweep (fixed left/right script)
+//   --taps=N         fire presses per second (default 8)
+//   --minutes=N      game time after which a run counts as survived (default 10)
+//   --seed=N         seed of game 0; game i uses seed + i
+//   --threads=N      threads, this one included (default: all cores)
+//   --tuning=PATH    tuning file to balance (default Tuning.txt)
+//   --telemetry=PATH game 0 of each mode also writes its telemetry to PATH,
+//                    as the game would, and checks that every level (or
+//                    survival minute) got a period of its own
+//
+// Every game owns its World and random stream, so results depend only on the
+// seed, the pilot and the tuning, never on the thread count. The summary goes
+// to stderr, the same numbers as JSON to stdout.
+
+#include "Game.hpp"
+#include "Telemetry.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+enum Pilot
+{
+    PILOT_DODGE,
+    PILOT_SWEEP
+};
+
+struct RunConfig
+{
+    int games = 1000;
+    std::vector<GameMode> modes = {MODE_NORMAL, MODE_HARD, MODE_SURVIVAL};
+    Pilot pilot = PILOT_DODGE;
+    int tapsPerSecond = 8;
+    float maxMinutes = 10.f;
+    unsigned seed = 1;
+    unsigned workers = JobSystem::defaultWorkers();
+    std::string tuningFile = TUNING_FILE;
+    std::string telemetryFile;
+};
+
+struct GameResult
+{
+    unsigned seed = 0;
+    bool died = false;
+    int level = 1;
+    float seconds = 0.f;
+    int damageTaken = 0;
+    int score = 0;
+    int periods = 0;         // telemetry periods started, game 0 only
+    bool periodsOk = true;   // each one at a level or minute change
+};
+
+// What follows `prefix` in the first argument starting with it, or nullptr
+const char *flagValue(int argc, char *argv[], const std::string &prefix)
+{
+    for (int a = 1; a < argc; ++a)
+        if (std::string(argv[a]).compare(0, prefix.size(), prefix) == 0)
+            return argv[a] + prefix.size();
+    return nullptr;
+}
+
+RunConfig parseConfig(int argc, char *argv[])
+{
+    RunConfig cfg;
+    if (const char *v = flagValue(argc, argv, "--games="))
+        cfg.games = std::max(1, std::atoi(v));
+    if (const char *v = flagValue(argc, argv, "--mode="))
+    {
+        std::string m = v;
+        if (m == "normal")
+            cfg.modes = {MODE_NORMAL};
+        else if (m == "hard")
+            cfg.modes = {MODE_HARD};
+        else if (m == "survival")
+            cfg.modes = {MODE_SURVIVAL};
+    }
+    if (const char *v = flagValue(argc, argv, "--pilot="))
+        cfg.pilot = std::strcmp(v, "sweep") == 0 ? PILOT_SWEEP : PILOT_DODGE;
+    if (const char *v = flagValue(argc, argv, "--taps="))
+        cfg.tapsPerSecond = std::max(1, std::atoi(v));
+    if (const char *v = flagValue(argc, argv, "--minutes="))
+        cfg.maxMinutes = std::max(0.1f, (float)std::atof(v));
+    if (const char *v = flagValue(argc, argv, "--seed="))
+        cfg.seed = (unsigned)std::strtoul(v, nullptr, 10);
+    if (const char *v = flagValue(argc, argv, "--threads="))
+        cfg.workers = (unsigned)std::max(1, std::atoi(v)) - 1;
+    if (const char *v = flagValue(argc, argv, "--tuning="))
+        cfg.tuningFile = v;
+    if (const char *v = flagValue(argc, argv, "--telemetry="))
+        cfg.telemetryFile = v;
+    return cfg;
+}
+
+// ---------------------------------------------------------------------------
+// Autopilots. Both tap fire at a steady rate, since holding Space only fires
+// once; they differ in how they move.
+
+// Left and right in 1.5 s strokes, like bench.cpp's scripted input
+float sweepMove(long long tick)
+{
+    return (tick / 90) % 2 ? -1.f : 1.f;
+}
+
+// How bad standing at `x` is: every bullet or diving enemy due to cross the
+// player's row near `x` soon, the sooner the worse
+float dangerAt(const World &w, float x)
+{
+    const float HORIZON = 0.8f;
+    const float py = w.player.pos.y;
+    const float reach = w.player.radius + 10.f;
+    float danger = 0.f;
+
+    auto threat = [&](const sf::Vector2f &pos, const sf::Vector2f &vel, float radius)
+    {
+        if (vel.y <= 0.f || pos.y > py + reach)
+            return;
+        float t = std::max(0.f, (py - pos.y) / vel.y);
+        if (t > HORIZON)
+            return;
+        float dx = std::fabs(pos.x + vel.x * t - x);
+        if (dx < reach + radius)
+            danger += 1.f / (t + 0.05f);
+    };
+
+    const Position *bulletPos = w.eBullets.column<Position>();
+    const Velocity *bulletVel = w.eBullets.column<Velocity>();
+    for (int i = 0; i < w.eBullets.size(); ++i)
+        threat(bulletPos[i], bulletVel[i], BULLET_RADIUS);
+    // Divers as if they kept their present heading at DIVE_SPEED
+    const Position *enemyPos = w.enemies.column<Position>();
+    const Body *body = w.enemies.column<Body>();
+    const Dive *dive = w.enemies.column<Dive>();
+    for (int i = 0; i < w.enemies.size(); ++i)
+        if (dive[i].attackMode && !dive[i].returning)
+        {
+            sf::Vector2f vel = divePaths().dives[dive[i].pattern].heading(dive[i].along) * DIVE_SPEED;
+            if (dive[i].mirrored)
+                vel.x = -vel.x;
+            threat(enemyPos[i], vel, body[i].radius);
+        }
+    return danger;
+}
+
+// Where the pilot would like to be with nothing to dodge: under the lowest
+// enemy, or on an item when one is falling close by
+float preferredX(const World &w)
+{
+    const sf::Vector2f &p = w.player.pos;
+    const Position *itemPos = w.items.column<Position>();
+    for (int i = 0; i < w.items.size(); ++i)
+        if (std::fabs(itemPos[i].x - p.x) < 250.f)
+            return itemPos[i].x;
+
+    float bestY = -1.f, x = p.x;
+    auto lowest = [&](const Position *pos, int count)
+    {
+        for (int i = 0; i < count; ++i)
+            if (pos[i].y > bestY)
+            {
+                bestY = pos[i].y;
+                x = pos[i].x;
+            }
+    };
+    lowest(w.enemies.column<Position>(), w.enemies.size());
+    lowest(w.bosses.column<Position>(), w.bosses.size());
+    return x;
+}
+
+// Try a row of spots around the player and head for the safest, breaking
+// ties toward the preferred one
+float dodgeMove(const World &w)
+{
+    const float STEP = 30.f;
+    const int SPOTS = 8; // each side
+    const float px = w.player.pos.x;
+    const float want = preferredX(w);
+
+    float bestX = px, bestCost = 1e30f;
+    for (int s = -SPOTS; s <= SPOTS; ++s)
+    {
+        float x = px + s * STEP;
+        if (x < w.player.radius || x > WINDOW_WIDTH - w.player.radius)
+            continue;
+        // Danger first, then the preferred spot, then staying close
+        float cost = dangerAt(w, x) * 100.f + std::fabs(x - want) * 0.01f + std::abs(s) * 0.5f;
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestX = x;
+        }
+    }
+    float stepPx = tuning.playerSpeed * TICK_SECONDS;
+    return std::max(-1.f, std::min(1.f, (bestX - px) / stepPx));
+}
+
+// ---------------------------------------------------------------------------
+
+void poolRefusals(const World &w, unsigned (&refused)[TELEMETRY_POOLS])
+{
+    refused[POOL_ENEMIES] = w.enemies.refused() + w.bosses.refused();
+    refused[POOL_P_BULLETS] = w.pBullets.refused();
+    refused[POOL_E_BULLETS] = w.eBullets.refused();
+    refused[POOL_ITEMS] = w.items.refused();
+    refused[POOL_EXPLOSIONS] = w.explosions.refused();
+}
+
+// `telemetry` is fed the way main.cpp feeds it, when not null
+GameResult playGame(World &w, JobSystem &inlineJobs, GameMode mode, unsigned seed, const RunConfig &cfg,
+                    Telemetry *telemetry = nullptr)
+{
+    w = World();
+    w.mode = mode;
+    w.rng.seed(seed);
+    carveWorld(w, capacitiesFor(mode, Capacities()));
+    resetGame(w);
+
+    GameResult r;
+    r.seed = seed;
+    const long long maxTicks = (long long)(cfg.maxMinutes * 60.f / TICK_SECONDS);
+    const int tapEvery = std::max(2, (int)(1.f / (cfg.tapsPerSecond * TICK_SECONDS)));
+
+    const bool survival = mode == MODE_SURVIVAL;
+    int lastLevel = -1, lastMinute = -1;
+    unsigned refused[TELEMETRY_POOLS];
+    long long tick = 0;
+    for (; tick < maxTicks; ++tick)
+    {
+        TickInput in;
+        in.moveDir = cfg.pilot == PILOT_SWEEP ? sweepMove(tick) : dodgeMove(w);
+        in.firePressed = tick % tapEvery == 0;
+
+        auto tickStart = std::chrono::steady_clock::now();
+        if (telemetry)
+        {
+            // A new period exactly when the level or survival minute moved on
+            const int level = survival ? 0 : w.level;
+            const int minute = survival ? (int)(w.survivalTimer / 60.f) : -1;
+            poolRefusals(w, refused);
+            const bool started = telemetry->enterPeriod(modeName(mode), level, minute, refused);
+            r.periods += started;
+            if (started != (level != lastLevel || minute != lastMinute))
+                r.periodsOk = false;
+            lastLevel = level;
+            lastMinute = minute;
+        }
+        TickEvents ev;
+        updateWorld(w, in, TICK_SECONDS, inlineJobs, ev);
+        if (telemetry)
+        {
+            const int live[TELEMETRY_POOLS] = {w.enemies.size() + w.bosses.size(), w.pBullets.size(),
+                                               w.eBullets.size(), w.items.size(), w.explosions.size()};
+            telemetry->onTick(std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - tickStart).count(),
+                              live);
+        }
+        r.damageTaken += ev.damageTaken;
+        if (w.player.hp <= 0)
+        {
+            r.died = true;
+            ++tick;
+            break;
+        }
+    }
+    if (telemetry)
+    {
+        poolRefusals(w, refused);
+        telemetry->endPeriod(refused);
+    }
+    r.seconds = tick * TICK_SECONDS;
+    r.level = w.level;
+    r.score = w.score;
+    return r;
+}
+
+// Every game of one mode, spread over the pool. Each chunk plays its games
+// one after another in its own World, with a JobSystem that runs inline.
+// Game 0 feeds `telemetry`, when not null.
+std::vector<GameResult> playMode(GameMode mode, const RunConfig &cfg, JobSystem &pool, Telemetry *telemetry)
+{
+    std::vector<GameResult> results(cfg.games);
+    pool.parallelFor(cfg.games, 1, [&](int begin, int end)
+                     {
+                         JobSystem inlineJobs(0);
+                         World w;
+                         for (int g = begin; g < end; ++g)
+                             results[g] = playGame(w, inlineJobs, mode, cfg.seed + (unsigned)g, cfg,
+                                                   g == 0 ? telemetry : nullptr); });
+    return results;
+}
+
+// ---------------------------------------------------------------------------
+// Report
+
+struct Spread
+{
+    float mean = 0.f, p10 = 0.f, p50 = 0.f, p90 = 0.f, max = 0.f;
+};
+
+Spread spreadOf(std::vector<float> v)
+{
+    Spread s;
+    if (v.empty())
+        return s;
+    std::sort(v.begin(), v.end());
+    double sum = 0.0;
+    for (float x : v)
+        sum += x;
+    s.mean = (float)(sum / v.size());
+    s.p10 = v[v.size() / 10];
+    s.p50 = v[v.size() / 2];
+    s.p90 = v[v.size() * 9 / 10];
+    s.max = v.back();
+    return s;
+}
+
+struct ModeReport
+{
+    GameMode mode;
+    int games = 0;
+    int deaths = 0;
+    std::map<int, int> deathLevels; // level -> games that ended there
+    Spread seconds, damage, score, level;
+    GameResult shortest; // worth replaying by its seed
+    double wallSeconds = 0.0;
+};
+
+ModeReport summarize(GameMode mode, const std::vector<GameResult> &results, double wallSeconds)
+{
+    ModeReport rep;
+    rep.mode = mode;
+    rep.games = (int)results.size();
+    rep.wallSeconds = wallSeconds;
+    std::vector<float> seconds, damage, score, level;
+    rep.shortest = results.front();
+    for (const GameResult &r : results)
+    {
+        if (r.died)
+        {
+            rep.deaths++;
+            rep.deathLevels[r.level]++;
+        }
+        if (r.seconds < rep.shortest.seconds)
+            rep.shortest = r;
+        seconds.push_back(r.seconds);
+        damage.push_back((float)r.damageTaken);
+        score.push_back((float)r.score);
+        level.push_back((float)r.level);
+    }
+    rep.seconds = spreadOf(seconds);
+    rep.damage = spreadOf(damage);
+    rep.score = spreadOf(score);
+    rep.level = spreadOf(level);
+    return rep;
+}
+
+void printSpread(const char *name, const Spread &s)
+{
+    std::fprintf(stderr, "  %-14s mean %9.1f  p10 %9.1f  p50 %9.1f  p90 %9.1f  max %9.1f\n",
+                 name, s.mean, s.p10, s.p50, s.p90, s.max);
+}
+
+void printReport(const ModeReport &rep)
+{
+    std::fprintf(stderr, "%s: %d games in %.1f s, %d died (%.1f%%), shortest seed %u (%.1f s)\n",
+                 modeName(rep.mode), rep.games, rep.wallSeconds, rep.deaths,
+                 100.0 * rep.deaths / rep.games, rep.shortest.seed, rep.shortest.seconds);
+    printSpread("survived s", rep.seconds);
+    printSpread("damage taken", rep.damage);
+    printSpread("score", rep.score);
+    printSpread("level", rep.level);
+    if (!rep.deathLevels.empty())
+    {
+        std::fprintf(stderr, "  deaths by level:");
+        for (const auto &kv : rep.deathLevels)
+            std::fprintf(stderr, " %d:%d", kv.first, kv.second);
+        std::fprintf(stderr, "\n");
+    }
+}
+
+void printSpreadJson(const char *name, const Spread &s, const char *tail)
+{
+    std::printf("      \"%s\": {\"mean\": %.2f, \"p10\": %.2f, \"p50\": %.2f, \"p90\": %.2f, \"max\": %.2f}%s\n",
+                name, s.mean, s.p10, s.p50, s.p90, s.max, tail);
+}
+
+void printJson(const RunConfig &cfg, const std::vector<ModeReport> &reports)
+{
+    std::printf("{\n  \"seed\": %u,\n  \"games_per_mode\": %d,\n  \"pilot\": \"%s\",\n  \"taps_per_second\": %d,\n"
+                "  \"max_minutes\": %.2f,\n  \"tuning\": \"%s\",\n  \"modes\": [\n",
+                cfg.seed, cfg.games, cfg.pilot == PILOT_SWEEP ? "sweep" : "dodge", cfg.tapsPerSecond,
+                cfg.maxMinutes, cfg.tuningFile.c_str());
+    for (std::size_t i = 0; i < reports.size(); ++i)
+    {
+        const ModeReport &rep = reports[i];
+        std::printf("    {\n      \"mode\": \"%s\",\n      \"games\": %d,\n      \"deaths\": %d,\n"
+                    "      \"shortest_seed\": %u,\n",
+                    modeName(rep.mode), rep.games, rep.deaths, rep.shortest.seed);
+        std::printf("      \"death_levels\": {");
+        bool first = true;
+        for (const auto &kv : rep.deathLevels)
+        {
+            std::printf("%s\"%d\": %d", first ? "" : ", ", kv.first, kv.second);
+            first = false;
+        }
+        std::printf("},\n");
+        printSpreadJson("survived_seconds", rep.seconds, ",");
+        printSpreadJson("damage_taken", rep.damage, ",");
+        printSpreadJson("score", rep.score, ",");
+        printSpreadJson("level", rep.level, "");
+        std::printf("    }%s\n", i + 1 < reports.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+    RunConfig cfg = parseConfig(argc, argv);
+    if (!loadTuning(cfg.tuningFile, tuning))
+        std::fprintf(stderr, "%s not loaded, using the built-in tuning\n", cfg.tuningFile.c_str());
+
+    JobSystem pool(cfg.workers);
+    std::fprintf(stderr, "%d games per mode on %d threads, %s pilot\n", cfg.games, pool.threadCount(),
+                 cfg.pilot == PILOT_SWEEP ? "sweep" : "dodge");
+
+    Telemetry telemetry;
+    if (!cfg.telemetryFile.empty() && !telemetry.open(cfg.telemetryFile, "balance", 1, "headless"))
+        std::fprintf(stderr, "Failed to open %s\n", cfg.telemetryFile.c_str());
+
+    std::vector<ModeReport> reports;
+    bool periodsOk = true;
+    for (GameMode mode : cfg.modes)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<GameResult> results = playMode(mode, cfg, pool, telemetry.isEnabled() ? &telemetry : nullptr);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        reports.push_back(summarize(mode, results, wall));
+        printReport(reports.back());
+        if (telemetry.isEnabled())
+        {
+            const GameResult &r = results.front();
+            std::fprintf(stderr, "  telemetry      game 0 wrote %d periods, one per %s: %s\n", r.periods,
+                         mode == MODE_SURVIVAL ? "minute" : "level", r.periodsOk ? "yes" : "no");
+            periodsOk = periodsOk && r.periodsOk;
+        }
+    }
+    telemetry.close();
+    printJson(cfg, reports);
+    return periodsOk ? 0 : 1;
+}
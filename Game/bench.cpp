@@ -0,0 +1,498 @@
+// Micro-benchmarks for the game's hot kernels.
+//
+// Build and run from this folder, e.g.
+//   g++ -std=c++17 -O2 -pthread bench.cpp -o bench -lsfml-system
+//   ./bench > bench.json
+//
+// Every benchmark is seeded, warmed up, then timed in batches; the median
+// batch is reported as ns/op plus heap allocations and bytes per op, as JSON.
+// updateWorld is timed on one thread and on all cores, and the two runs are
+// checked to end in the same world.
+// File benchmarks run inside a scratch folder so real saves are never touched.
+
+#include "Game.hpp"
+#include "AllocStats.hpp"
+#include "Rewind.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+const unsigned SEED = 20240601;
+const int WARMUP_CALLS = 200;
+const double MIN_BATCH_SECONDS = 0.05;
+const int BATCHES = 7;
+
+// Keeps results alive so the optimizer can't drop the work
+volatile float sinkF;
+volatile int sinkI;
+
+struct BenchResult
+{
+    std::string name;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+    long long ops;
+};
+
+std::vector<BenchResult> results;
+
+// fn() does `opsPerCall` operations; setup() runs before warm-up (seeding etc.)
+template <typename Setup, typename Fn>
+void bench(const std::string &name, int opsPerCall, Setup setup, Fn fn)
+{
+    using Clock = std::chrono::steady_clock;
+    setup();
+    for (int i = 0; i < WARMUP_CALLS; ++i)
+        fn();
+
+    // Grow the batch until one batch takes long enough to time reliably
+    long long calls = 1;
+    for (;;)
+    {
+        auto t0 = Clock::now();
+        for (long long i = 0; i < calls; ++i)
+            fn();
+        double s = std::chrono::duration<double>(Clock::now() - t0).count();
+        if (s >= MIN_BATCH_SECONDS || calls > (1LL << 30))
+            break;
+        calls *= 2;
+    }
+
+    std::vector<double> ns;
+    unsigned long long allocs = 0, bytes = 0;
+    for (int b = 0; b < BATCHES; ++b)
+    {
+        unsigned long long a0 = allocStats.count.load(), b0 = allocStats.bytes.load();
+        auto t0 = Clock::now();
+        for (long long i = 0; i < calls; ++i)
+            fn();
+        auto t1 = Clock::now();
+        allocs += allocStats.count.load() - a0;
+        bytes += allocStats.bytes.load() - b0;
+        ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)(calls * opsPerCall));
+    }
+    std::sort(ns.begin(), ns.end());
+
+    double totalOps = (double)calls * opsPerCall * BATCHES;
+    results.push_back({name, ns[BATCHES / 2], allocs / totalOps, bytes / totalOps, (long long)totalOps});
+    std::fprintf(stderr, "%-32s %10.2f ns/op\n", name.c_str(), ns[BATCHES / 2]);
+}
+
+// A playfield like the real one: formation enemies up top, bullets in flight
+struct Population
+{
+    EnemyRows enemies;
+    BulletRows bullets;
+};
+
+void makePopulation(Population &p, int liveEnemies, int liveBullets, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> x(40.f, WINDOW_WIDTH - 40.f);
+    std::uniform_real_distribution<float> yTop(80.f, 400.f);
+    std::uniform_real_distribution<float> y(0.f, (float)WINDOW_HEIGHT);
+
+    p.enemies.init(liveEnemies);
+    for (int i = 0; i < liveEnemies; ++i)
+    {
+        sf::Vector2f pos(x(rng), yTop(rng));
+        p.enemies.spawn(liveEnemies, pos, pos, Bob(), Weapon(), HitFlash(), Dive(), Body(), Health(), Rank());
+    }
+    p.bullets.init(liveBullets);
+    for (int i = 0; i < liveBullets; ++i)
+        p.bullets.spawn(liveBullets, sf::Vector2f(x(rng), y(rng)), sf::Vector2f(0.f, -tuning.pBulletSpeed), Damage());
+    p.enemies.flush();
+    p.bullets.flush();
+}
+
+void benchCollisions(const char *label, int liveEnemies, int liveBullets)
+{
+    Population p;
+    makePopulation(p, liveEnemies, liveBullets, SEED);
+    // Same shape as the player-bullet pass: every live bullet against every
+    // live enemy, straight down the columns
+    const Position *bulletPos = p.bullets.column<Position>();
+    const Position *enemyPos = p.enemies.column<Position>();
+    const Body *enemyBody = p.enemies.column<Body>();
+    const int pairs = liveBullets * liveEnemies;
+
+    bench(std::string("dist2/") + label, pairs, [] {}, [&]
+          {
+              float sum = 0.f;
+              for (int b = 0; b < liveBullets; ++b)
+                  for (int e = 0; e < liveEnemies; ++e)
+                      sum += dist2(bulletPos[b], enemyPos[e]);
+              sinkF = sum; });
+
+    bench(std::string("circleHit/") + label, pairs, [] {}, [&]
+          {
+              int hits = 0;
+              for (int b = 0; b < liveBullets; ++b)
+                  for (int e = 0; e < liveEnemies; ++e)
+                      if (circleHit(bulletPos[b], BULLET_RADIUS, enemyPos[e], enemyBody[e].radius))
+                          hits++;
+              sinkI = hits; });
+
+    // The swept test the game runs, over one tick of a player bullet's move
+    const sf::Vector2f move(0.f, -tuning.pBulletSpeed / 60.f);
+    bench(std::string("sweptCircleHit/") + label, pairs, [] {}, [&]
+          {
+              int hits = 0;
+              for (int b = 0; b < liveBullets; ++b)
+                  for (int e = 0; e < liveEnemies; ++e)
+                      if (sweptCircleHit(bulletPos[b], move, BULLET_RADIUS, enemyPos[e], enemyBody[e].radius) >= 0.f)
+                          hits++;
+              sinkI = hits; });
+}
+
+void benchMoveBullets(const char *label, int live)
+{
+    Population p;
+    makePopulation(p, 1, live, SEED);
+    Position *pos = p.bullets.column<Position>();
+    std::vector<Position> start(pos, pos + live);
+    // Tiny dt keeps bullets on screen for the whole run; reset once they drift
+    // off. Nothing is flushed, so the rows stay put.
+    long long calls = 0;
+    bench(std::string("moveBullets/") + label, live, [] {}, [&]
+          {
+              if (++calls % 4096 == 0)
+                  std::copy(start.begin(), start.end(), pos);
+              moveBullets(p.bullets, 0, live, 1.f / 2000.f); });
+}
+
+void benchFormationEdges(const char *label, int live)
+{
+    Population p;
+    makePopulation(p, live, 1, SEED);
+    const BasePos *base = p.enemies.column<BasePos>();
+    const Body *body = p.enemies.column<Body>();
+    Formation formation;
+    formation.reset();
+    for (int i = 0; i < live; ++i)
+        formation.join(base[i].x, body[i].radius);
+
+    // One member leaving and coming back, then the bounce test
+    int next = 0;
+    bench(std::string("formationEdges/") + label, 1, [] {}, [&]
+          {
+              formation.leave(base[next].x);
+              formation.join(base[next].x, body[next].radius);
+              next = (next + 1) % live;
+              sinkF = formation.maxX() - formation.minX(); });
+}
+
+// The per-tick enemy kernels over a whole formation: place it and advance
+// the bobbing
+void benchEnemyKernels(const char *label, int live)
+{
+    Population p;
+    makePopulation(p, live, 1, SEED);
+    float *pos = reinterpret_cast<float *>(p.enemies.column<Position>());
+    const float *base = reinterpret_cast<const float *>(p.enemies.column<BasePos>());
+    float *t = reinterpret_cast<float *>(p.enemies.column<Bob>());
+    sf::Vector2f offset;
+    bench(std::string("enemyKernels/") + label, live, [] {}, [&]
+          {
+              offset.x = offset.x > 100.f ? 0.f : offset.x + 0.5f;
+              placeInFormation(pos, base, live, offset);
+              advancePhases(t, live, 1.f / 60.f);
+              sinkF = pos[0]; });
+}
+
+// Every enemy out on a dive or on the way back, each sent out again as soon
+// as it is home: the per-tick cost of the movers
+void benchDivers(const char *label, int live)
+{
+    Capacities caps;
+    caps.enemies = live;
+    World w;
+    carveWorld(w, caps);
+    std::mt19937 rng(SEED);
+    std::uniform_real_distribution<float> x(40.f, WINDOW_WIDTH - 40.f);
+    std::uniform_real_distribution<float> y(80.f, 400.f);
+    for (int i = 0; i < live; ++i)
+    {
+        Enemy e;
+        e.pos = {x(rng), y(rng)};
+        e.basePos = e.pos;
+        e.attackMode = true;
+        addEnemy(w, e);
+    }
+    flushEnemies(w);
+    Dive *dive = w.enemies.column<Dive>();
+    for (int i = 0; i < live; ++i)
+    {
+        dive[i].pattern = (unsigned char)(i % DIVE_PATTERNS);
+        dive[i].mirrored = (i & 1) != 0;
+    }
+    EnemyStep step;
+    bench(std::string("divers/") + label, live, [] {}, [&]
+          {
+              stepEnemies(w, w.enemies, true, 1.f / 60.f, step);
+              for (int i = 0; i < live; ++i)
+                  if (isFormationMember(dive[i]))
+                      dive[i].attackMode = true;
+              sinkI = (int)step.movers.size(); });
+}
+
+// One tick of the timer wheel with `timers` cooldowns of 1-1.6 s running,
+// each re-armed when it fires, as enemy weapons are
+void benchTimerWheel(const char *label, int timers)
+{
+    TimerWheel<int> wheel;
+    std::vector<int> due;
+    std::minstd_rand rng(SEED);
+    bench(std::string("timerWheel/") + label, 1, [&]
+          {
+              wheel.clear();
+              for (int i = 0; i < timers; ++i)
+                  wheel.schedule(wheel.now() + 60 + rng() % 36, i);
+          }, [&]
+          {
+              due.clear();
+              wheel.advance(due);
+              for (int i : due)
+                  wheel.schedule(wheel.now() + 60 + rng() % 36, i);
+              sinkI = (int)due.size(); });
+}
+
+void benchBossPatterns()
+{
+    Capacities caps;
+    World w;
+    carveWorld(w, caps);
+    w.level = 10;
+
+    Enemy boss;
+    boss.boss = true;
+    boss.pos = {WINDOW_WIDTH / 2.f, 120.f};
+    boss.radius = 36.f;
+    addEnemy(w, boss);
+    w.bosses.flush();
+    BossBrain &brain = w.bosses.column<BossBrain>()[0];
+    Dive &dive = w.bosses.column<Dive>()[0];
+
+    for (int type = 0; type < 5; ++type)
+    {
+        for (int phase = 1; phase <= 4; ++phase)
+        {
+            // Each op is one volley plus dropping what it queued, so the
+            // pool never fills up
+            bench("fireBossBullet/type" + std::to_string(type) + "/phase" + std::to_string(phase), 1,
+                  [&] { w.rng.seed(SEED); }, [&]
+                  {
+                      brain.bossType = type;
+                      brain.phase = phase;
+                      dive.attackMode = false;
+                      fireBossBullet(w, 0);
+                      w.eBullets.clear();
+                      w.enemies.clear(); });
+        }
+    }
+}
+
+void benchText()
+{
+    int v = 0;
+    bench("toBinary", 1, [&]
+          { v = 0; }, [&]
+          {
+              std::string s = toBinary(v);
+              v = (v + 1) & 63;
+              sinkI = (int)s.size(); });
+
+    bench("makeBulletLabel", 1, [&]
+          { v = 0; }, [&]
+          {
+              std::string s = makeBulletLabel(v);
+              v = (v + 1) & 63;
+              sinkI = (int)s.size(); });
+}
+
+void benchFiles()
+{
+    Capacities caps;
+    World w;
+    carveWorld(w, caps);
+    Population p;
+    makePopulation(p, 18, 1, SEED);
+    const Position *pos = p.enemies.column<Position>();
+    for (int i = 0; i < p.enemies.size(); ++i)
+    {
+        Enemy e;
+        e.pos = pos[i];
+        e.basePos = e.pos;
+        addEnemy(w, e);
+    }
+    for (int i = 0; i < 4; ++i)
+        w.items.spawn(caps.items, sf::Vector2f(100.f + i * 50.f, 300.f), Pickup{(ItemType)i});
+    w.enemies.flush();
+    w.items.flush();
+    w.level = 7;
+    w.score = 1234;
+    w.player.style = DOUBLE;
+    const int SLOT = 9;
+
+    bench("saveGame+loadGame", 1, [] {}, [&]
+          {
+              saveGame(w, SLOT);
+              sinkI = loadGame(w, SLOT); });
+    std::remove(("Save" + std::to_string(SLOT) + ".txt").c_str());
+
+    int n = 0;
+    bench("addHighScore", 1, [&]
+          {
+              std::remove("HighScores.txt");
+              n = 0; }, [&]
+          {
+              addHighScore((n * 7919) % 5000, n % 30, (GameMode)(n % 3));
+              n++; });
+    std::remove("HighScores.txt");
+}
+
+// Fixed input script: sweep left and right, always firing
+TickInput scriptedInput(long long tick)
+{
+    TickInput in;
+    in.moveDir = (tick / 90) % 2 ? -1.f : 1.f;
+    in.fire = true;
+    return in;
+}
+
+// Stress-mode ticks on one thread and on all of them. The same seed and
+// input has to end in the same world whatever the thread count.
+bool benchTick()
+{
+    const float DT = TICK_SECONDS;
+    const int CHECK_TICKS = 600;
+    auto newGame = [](World &w, GameMode mode)
+    {
+        w = World();
+        w.mode = mode;
+        w.rng.seed(SEED);
+        carveWorld(w, capacitiesFor(mode, Capacities()));
+        spawnEnemy(w, w.level);
+    };
+
+    bool deterministic = true;
+    unsigned long long expected = 0;
+    // At least 4 threads, so chunks get split and stolen even on small machines
+    unsigned workerCounts[] = {0, std::max(3u, JobSystem::defaultWorkers())};
+    for (unsigned workers : workerCounts)
+    {
+        JobSystem jobs(workers);
+        World w;
+        TickEvents ev;
+
+        newGame(w, MODE_STRESS);
+        for (int t = 0; t < CHECK_TICKS; ++t)
+            updateWorld(w, scriptedInput(t), DT, jobs, ev);
+        unsigned long long sum = worldChecksum(w);
+        if (workers == 0)
+            expected = sum;
+        else if (sum != expected)
+            deterministic = false;
+
+        // Restart every few seconds of game time so the load stays comparable
+        long long tick = 0;
+        std::string threads = "/threads" + std::to_string(jobs.threadCount());
+        for (GameMode mode : {MODE_NORMAL, MODE_STRESS})
+        {
+            bench(std::string("updateWorld/") + (mode == MODE_STRESS ? "stress" : "normal") + threads, 1,
+                  [&]
+                  {
+                      newGame(w, mode);
+                      tick = 0;
+                  },
+                  [&]
+                  {
+                      if (++tick % CHECK_TICKS == 0)
+                          newGame(w, mode);
+                      updateWorld(w, scriptedInput(tick), DT, jobs, ev);
+                      sinkI = w.score;
+                  });
+        }
+    }
+    std::fprintf(stderr, "updateWorld same result on 1 and %u threads: %s\n",
+                 workerCounts[1] + 1, deterministic ? "yes" : "NO");
+    return deterministic;
+}
+
+// Rewind capture of a world in full play, as the game does after every tick.
+// It alternates between two worlds one tick apart, so every frame is a
+// realistic delta and the timing is the capture alone.
+void benchRewind()
+{
+    JobSystem jobs(0);
+    for (GameMode mode : {MODE_NORMAL, MODE_STRESS})
+    {
+        const Capacities caps = capacitiesFor(mode, Capacities());
+        World w;
+        w.mode = mode;
+        w.rng.seed(SEED);
+        carveWorld(w, caps);
+        spawnEnemy(w, w.level);
+        TickEvents ev;
+        for (long long t = 0; t < 600; ++t)
+            updateWorld(w, scriptedInput(t), TICK_SECONDS, jobs, ev);
+        World next = w;
+        updateWorld(next, scriptedInput(600), TICK_SECONDS, jobs, ev);
+
+        const float SECONDS = 20.f;
+        RewindBuffer rewind(SECONDS);
+        long long n = 0;
+        const std::string name = mode == MODE_STRESS ? "stress" : "normal";
+        bench("rewindCapture/" + name, 1, [] {}, [&]
+              { rewind.capture(++n % 2 ? next : w); });
+        std::fprintf(stderr, "%-32s %10.1f KB for %.0f s\n", ("rewindMemory/" + name).c_str(),
+                     rewind.bytes() / 1024.0, SECONDS);
+    }
+}
+
+int main()
+{
+    std::string cwd = std::filesystem::current_path().string();
+    loadTuning(TUNING_FILE, tuning);
+
+    // Save and high-score benchmarks write files; keep them out of the game folder
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "numeric-invasion-bench";
+    std::filesystem::create_directories(scratch);
+    std::filesystem::current_path(scratch);
+
+    benchCollisions("normal", 18, 16);
+    benchCollisions("stress", 480, 256);
+    benchMoveBullets("normal", 24);
+    benchMoveBullets("stress", 8000);
+    benchFormationEdges("normal", 18);
+    benchFormationEdges("stress", 480);
+    benchEnemyKernels("normal", 18);
+    benchEnemyKernels("stress", 480);
+    benchDivers("normal", 18);
+    benchDivers("stress", 480);
+    benchTimerWheel("normal", 18);
+    benchTimerWheel("stress", 10000);
+    benchBossPatterns();
+    benchText();
+    bool deterministic = benchTick();
+    benchRewind();
+    benchFiles();
+
+    std::filesystem::current_path(cwd);
+    std::filesystem::remove_all(scratch);
+
+    std::printf("{\n  \"seed\": %u,\n  \"threads\": %u,\n  \"tick_deterministic\": %s,\n  \"benchmarks\": [\n",
+                SEED, JobSystem::defaultWorkers() + 1, deterministic ? "true" : "false");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult &r = results[i];
+        std::printf("    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"allocs_per_op\": %.4f, \"bytes_per_op\": %.2f, \"ops\": %lld}%s\n",
+                    r.name.c_str(), r.nsPerOp, r.allocsPerOp, r.bytesPerOp, r.ops,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return 0;
+}
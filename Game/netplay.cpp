@@ -0,0 +1,193 @@
+// Loopback co-op check: a host and a guest in one process, talking over
+// 127.0.0.1 through a made-up bad network, each pressing its own scripted
+// keys in real time. Afterwards both play out the inputs they were missing
+// and must end on the same world, bit for bit.
+//
+// Build and run from this folder, e.g.
+//   g++ -std=c++17 -O2 -pthread netplay.cpp -o netplay -lsfml-network -lsfml-system
+//   ./netplay --seconds=30 --net-delay=60 --net-jitter=30 --net-loss=5
+//
+// Flags:
+//   --seconds=N        how long to play (default 20)
+//   --mode=M           normal, hard or survival (default normal)
+//   --seed=N           game seed (default 1)
+//   --port=N           host port (default 7777)
+//   --input-delay=N    ticks of input delay (default 2)
+//   --net-delay=ms     added to every datagram, each way (default 50)
+//   --net-jitter=ms    up to this much more, reordering some (default 20)
+//   --net-loss=P       percent of datagrams dropped (default 5)
+//   --guest-lag=ms     how long after the host the guest starts (default 300)
+//   --threads=N        threads per tick, this one included (default 1)
+//
+// Exits with 1 if the two worlds differ.
+
+#include "Rollback.hpp"
+#include <cstdio>
+#include <thread>
+
+const char *flagValue(int argc, char *argv[], const std::string &prefix)
+{
+    for (int a = 1; a < argc; ++a)
+        if (std::string(argv[a]).compare(0, prefix.size(), prefix) == 0)
+            return argv[a] + prefix.size();
+    return nullptr;
+}
+
+using Clock = std::chrono::steady_clock;
+
+// One machine: its connection, its copy of the game and its tick clock
+struct Side
+{
+    const char *name = "";
+    int player = 0;
+    Netplay net;
+    World world;
+    Clock::time_point nextTick;
+    unsigned ticks = 0; // advanced, waits not counted
+};
+
+// Different keys on each side, so guesses go wrong now and then: sweeps of
+// uneven length, fire held for a while, taps in between
+TickInput scriptedInput(int player, unsigned tick)
+{
+    TickInput in;
+    const unsigned stroke = player == 0 ? 70 : 110;
+    in.moveDir = (tick / stroke) % 2 ? -1.f : 1.f;
+    if ((tick / 23 + player) % 5 == 0)
+        in.moveDir *= 0.5f;
+    in.fire = (tick / 40 + player) % 3 == 0;
+    in.firePressed = tick % (player == 0 ? 9 : 13) == 0;
+    return in;
+}
+
+int main(int argc, char *argv[])
+{
+    loadTuning(TUNING_FILE, tuning);
+
+    double seconds = 20.0;
+    if (const char *v = flagValue(argc, argv, "--seconds="))
+        seconds = std::max(1.0, std::atof(v));
+    NetGame game;
+    game.seed = 1;
+    if (const char *v = flagValue(argc, argv, "--seed="))
+        game.seed = (unsigned)std::strtoul(v, nullptr, 10);
+    if (const char *v = flagValue(argc, argv, "--mode="))
+    {
+        std::string m = v;
+        game.mode = m == "hard" ? MODE_HARD : m == "survival" ? MODE_SURVIVAL : MODE_NORMAL;
+    }
+    if (const char *v = flagValue(argc, argv, "--input-delay="))
+        game.inputDelay = std::max(0, std::min(RollbackSession::MAX_INPUT_DELAY, std::atoi(v)));
+    game.caps = capacitiesFor(game.mode, Capacities());
+    game.tuningSum = tuningChecksum(tuning);
+    unsigned short port = DEFAULT_NET_PORT;
+    if (const char *v = flagValue(argc, argv, "--port="))
+        port = (unsigned short)std::atoi(v);
+    NetConditions conditions;
+    conditions.delayMs = 50;
+    conditions.jitterMs = 20;
+    conditions.lossPercent = 5.f;
+    if (const char *v = flagValue(argc, argv, "--net-delay="))
+        conditions.delayMs = std::max(0, std::atoi(v));
+    if (const char *v = flagValue(argc, argv, "--net-jitter="))
+        conditions.jitterMs = std::max(0, std::atoi(v));
+    if (const char *v = flagValue(argc, argv, "--net-loss="))
+        conditions.lossPercent = (float)std::atof(v);
+    int guestLagMs = 300;
+    if (const char *v = flagValue(argc, argv, "--guest-lag="))
+        guestLagMs = std::max(0, std::atoi(v));
+    unsigned workers = 0;
+    if (const char *v = flagValue(argc, argv, "--threads="))
+        workers = (unsigned)std::max(1, std::atoi(v)) - 1;
+    JobSystem jobs(workers);
+
+    Side sides[2];
+    sides[0].name = "host";
+    sides[1].name = "guest";
+    sides[1].player = 1;
+    if (!sides[0].net.host(port, game, conditions))
+    {
+        std::fprintf(stderr, "port %d is taken\n", port);
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(guestLagMs));
+    if (!sides[1].net.join(sf::IpAddress::LocalHost, port, conditions))
+        return 1;
+
+    std::printf("%.0f s of %s, %d ms +%d ms, %.1f%% loss, input delay %d\n", seconds, modeName(game.mode),
+                conditions.delayMs, conditions.jitterMs, conditions.lossPercent, game.inputDelay);
+
+    // Play in real time: one tick per TICK_SECONDS on each side's own clock
+    const unsigned lastTick = (unsigned)std::lround(seconds / TICK_SECONDS);
+    const Clock::duration tickLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(TICK_SECONDS));
+    const Clock::time_point giveUp = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds * 3 + 10));
+    auto done = [&](Side &s)
+    {
+        RollbackSession &r = s.net.session();
+        return s.net.hasBegun() && (r.isOver() || r.tick() >= lastTick);
+    };
+    while (!(done(sides[0]) && done(sides[1])) && Clock::now() < giveUp)
+    {
+        for (Side &s : sides)
+        {
+            s.net.poll();
+            if (s.net.isReady() && !s.net.hasBegun())
+            {
+                const NetGame &g = s.net.netGame();
+                s.world.mode = g.mode;
+                s.world.coop = true;
+                s.world.rng.seed(g.seed);
+                carveWorld(s.world, g.caps);
+                resetGame(s.world);
+                s.net.begin(s.world);
+                s.nextTick = Clock::now();
+            }
+            if (!s.net.hasBegun())
+                continue;
+            RollbackSession &r = s.net.session();
+            while (!done(s) && Clock::now() >= s.nextTick)
+            {
+                s.nextTick += tickLength;
+                if (s.net.shouldWait())
+                    continue;
+                TickEvents ev;
+                r.advance(s.world, scriptedInput(s.player, r.tick()), jobs, ev);
+                s.ticks++;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Neither side ticks any more; trade the last inputs until both have
+    // played every tick on real input, or the same game over
+    auto settled = [&](Side &s)
+    {
+        RollbackSession &r = s.net.session();
+        r.catchUp(s.world, jobs);
+        return r.isOver() || r.confirmed();
+    };
+    while (!(settled(sides[0]) && settled(sides[1])) && Clock::now() < giveUp)
+    {
+        for (Side &s : sides)
+            s.net.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool same = true;
+    unsigned long long sums[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        Side &s = sides[i];
+        RollbackSession &r = s.net.session();
+        sums[i] = worldChecksum(s.world);
+        std::printf("%-5s  tick %u%s  checksum %016llx  score %d  hp %d/%d%s\n", s.name, r.isOver() ? r.overAt() : r.tick(),
+                    r.isOver() ? " (over)" : "", sums[i], s.world.score, s.world.player.hp, s.world.player2.hp,
+                    r.desynced() ? "  DESYNC" : "");
+        same = same && !r.desynced() && (r.confirmed() || r.isOver());
+        s.net.stop();
+    }
+    const RollbackSession &h = sides[0].net.session(), &g = sides[1].net.session();
+    same = same && sums[0] == sums[1] && h.isOver() == g.isOver() && (h.isOver() ? h.overAt() == g.overAt() : h.tick() == g.tick());
+    std::printf("worlds match: %s\n", same ? "yes" : "no");
+    return same ? 0 : 1;
+}